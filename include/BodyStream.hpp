@@ -0,0 +1,148 @@
+#ifndef BODY_STREAM_HPP
+#define BODY_STREAM_HPP
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/**
+ * @class ChunkedDecoder
+ * @brief Incremental decoder for "Transfer-Encoding: chunked" message bodies (RFC 9112, section 7.1).
+ *
+ * Input may be fed in pieces of any size. Payload is returned as views into the caller's input,
+ * so decoding copies nothing; only the chunk framing is interpreted. Chunk extensions and
+ * trailer fields are skipped.
+ */
+class ChunkedDecoder {
+public:
+    enum class Status {
+        NEED_MORE,  ///< All input was consumed; feed more.
+        DATA,       ///< A slice of payload was produced.
+        DONE,       ///< The terminating chunk and trailers were consumed.
+        ERROR       ///< The framing is malformed.
+    };
+
+    /**
+     * @brief Decodes the next step from input.
+     * @param input Unconsumed bytes of the connection.
+     * @param consumed Receives the number of input bytes used (framing and payload).
+     * @param data On DATA, receives the payload slice (a view into input).
+     * @return Status What was decoded.
+     */
+    Status decode(std::string_view input, size_t& consumed, std::string_view& data);
+
+    /// True once the whole body was decoded.
+    [[nodiscard]] bool done() const { return state == State::DONE; }
+
+private:
+    enum class State { SIZE, EXTENSION, SIZE_LF, DATA, DATA_CR, DATA_LF, TRAILER, TRAILER_LF, DONE, ERROR };
+
+    static constexpr size_t MAX_LINE_BYTES = 4096;   ///< Bound on a size line with extensions, or a trailer line.
+
+    State state = State::SIZE;
+    uint64_t chunk_left = 0;
+    size_t size_digits = 0;
+    size_t line_bytes = 0;
+};
+
+/**
+ * @class BodyStream
+ * @brief Pull-based reader for one request body, framed by Content-Length or chunked encoding.
+ *
+ * The socket is only read when the consumer asks for the next slice, so a handler that
+ * processes data slower than the client sends it simply stops pulling: the kernel receive
+ * buffer fills, the TCP window closes and the client is throttled, while server memory stays at
+ * one slice. Bytes already in the connection buffer are used first, and on destruction the
+ * consumed prefix is erased so whatever follows the body (a pipelined request) stays there.
+ */
+class BodyStream {
+public:
+    static constexpr size_t SLICE_SIZE = 16384;      ///< Largest slice returned by one socket read.
+
+    /// Selects the chunked-encoding constructor.
+    struct Chunked {};
+
+    /**
+     * @brief Reads a body of known length.
+     * @param socket The client socket to pull the rest of the body from.
+     * @param pending The connection buffer; it starts right after the request headers.
+     * @param content_length The declared body length.
+     */
+    BodyStream(int socket, std::string& pending, size_t content_length);
+
+    /**
+     * @brief Reads a chunked body.
+     * @param socket The client socket to pull the rest of the body from.
+     * @param pending The connection buffer; it starts right after the request headers.
+     * @param limit Largest accepted decoded size; exceeding it fails the stream (see too_large()).
+     */
+    BodyStream(int socket, std::string& pending, Chunked, size_t limit);
+
+    ~BodyStream();
+
+    BodyStream(const BodyStream&) = delete;
+    BodyStream& operator=(const BodyStream&) = delete;
+
+    /**
+     * @brief Returns the next slice of the body, blocking for at most one socket read.
+     * @return std::string_view The slice, valid until the next call; empty at the end of the body or on error.
+     */
+    std::string_view next();
+
+    /**
+     * @brief Copies up to size bytes of the body into dst.
+     * @return size_t The number of bytes copied; 0 at the end of the body or on error.
+     */
+    size_t read(char* dst, size_t size);
+
+    /**
+     * @brief Appends the rest of the body to out.
+     * @return bool True if the whole body was received.
+     */
+    bool read_all(std::string& out);
+
+    /**
+     * @brief Reads and drops whatever the consumer left unread, keeping the connection in sync.
+     * @param max_bytes Give up (and report failure) rather than drain more than this.
+     * @return bool True if the body was fully consumed.
+     */
+    bool discard(size_t max_bytes);
+
+    /// True once every byte of the body has been returned.
+    [[nodiscard]] bool finished() const { return complete && partial.empty(); }
+
+    /// True if the client disconnected, timed out, broke the chunk framing or exceeded the limit.
+    [[nodiscard]] bool failed() const { return error; }
+
+    /// True if a chunked body grew past its limit.
+    [[nodiscard]] bool too_large() const { return over_limit; }
+
+    /// True for a chunked body, whose length is not known up front.
+    [[nodiscard]] bool chunked() const { return is_chunked; }
+
+    /// Body bytes returned so far.
+    [[nodiscard]] size_t received() const { return total; }
+
+private:
+    int socket;
+    std::string& pending;
+    size_t pending_pos = 0;                          ///< Bytes of pending already consumed.
+    bool is_chunked = false;
+    size_t remaining = 0;                            ///< Content-Length bytes not yet returned.
+    size_t limit = 0;                                ///< Chunked mode: decoded size cap.
+    size_t total = 0;
+    bool complete = false;
+    bool error = false;
+    bool over_limit = false;
+    ChunkedDecoder decoder;
+    std::string_view partial;                        ///< Unreturned tail of the last slice (read() only).
+    std::array<char, SLICE_SIZE> slice;
+
+    std::string_view next_fixed();
+    std::string_view next_chunked();
+};
+
+#endif // BODY_STREAM_HPP
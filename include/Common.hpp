@@ -3,8 +3,15 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <map>
+#include <vector>
+#include <array>
+#include <utility>
+#include <cstdint>
 #include <functional>
+#include <memory>
+#include <chrono>
 
 /**
  * @brief Maximum allowed size for an incoming HTTP payload (10 MB).
@@ -12,6 +19,167 @@
  */
 constexpr size_t MAX_PAYLOAD_SIZE = 10485760;
 
+/**
+ * @brief Maximum allowed size for a multipart/form-data upload (100 MB).
+ * File parts are streamed to temporary files, so this bounds disk usage rather than memory.
+ */
+constexpr size_t MAX_UPLOAD_SIZE = 104857600;
+
+/**
+ * @enum HttpMethod
+ * @brief Request methods the router keeps a dedicated handler slot for.
+ * UNKNOWN covers extension methods and is only reachable through catch-all routes.
+ */
+enum class HttpMethod : uint8_t {
+    GET,
+    HEAD,
+    POST,
+    PUT,
+    PATCH,
+    DELETE,
+    OPTIONS,
+    UNKNOWN
+};
+
+/// Number of handler slots per route (one per HttpMethod value, including UNKNOWN).
+constexpr size_t HTTP_METHOD_COUNT = static_cast<size_t>(HttpMethod::UNKNOWN) + 1;
+
+class JsonDocument;
+class BodyStream;
+class ResponseWriter;
+class PendingResponse;
+class WebSocket;
+class EventStream;
+
+/**
+ * @class ParamStore
+ * @brief Flat key-value store for query, form and JSON parameters.
+ *
+ * Keys and values are written back to back into a single string arena and indexed by offset,
+ * so a request with N parameters costs one arena allocation instead of 2N strings and N tree
+ * nodes. The index lives inline for the first INLINE_CAPACITY entries and lookups are a
+ * linear scan, which beats hashing or tree walks at the handful of parameters a request carries.
+ * Past that, an open-addressed hash table of entry indices takes over, so a body with thousands
+ * of fields still parses in linear time. Setting an existing key replaces its value (last one wins).
+ */
+class ParamStore {
+public:
+    static constexpr size_t INLINE_CAPACITY = 8;
+
+    using value_type = std::pair<std::string_view, std::string_view>;
+
+    class const_iterator {
+    public:
+        const_iterator(const ParamStore* store, size_t index) : store(store), index(index) {}
+        value_type operator*() const { return store->entry_at(index); }
+        const_iterator& operator++() { ++index; return *this; }
+        bool operator==(const const_iterator& other) const { return index == other.index; }
+        bool operator!=(const const_iterator& other) const { return index != other.index; }
+
+    private:
+        const ParamStore* store;
+        size_t index;
+    };
+
+    /// True if the key was set.
+    [[nodiscard]] bool contains(std::string_view key) const { return find(key) != nullptr; }
+
+    /**
+     * @brief Returns the value for a key.
+     * @throws std::out_of_range If the key is absent (mirrors std::map::at).
+     */
+    [[nodiscard]] std::string_view at(std::string_view key) const;
+
+    /**
+     * @brief Returns the value for a key, or a fallback if absent.
+     * @param key The parameter name.
+     * @param fallback The value to return when the key was never set.
+     */
+    [[nodiscard]] std::string_view get(std::string_view key, std::string_view fallback = {}) const;
+
+    /**
+     * @brief Copies a key-value pair into the store, replacing any previous value for the key.
+     */
+    void set(std::string_view key, std::string_view value);
+
+    /**
+     * @brief Decodes a raw key-value pair straight into the arena, then indexes it.
+     * @param raw_key The still-encoded key.
+     * @param raw_value The still-encoded value.
+     * @param decode A callable size_t(std::string_view src, char* dst) writing at most src.size() bytes.
+     */
+    template <typename Decoder>
+    void set_decoded(std::string_view raw_key, std::string_view raw_value, Decoder&& decode) {
+        size_t key_off = arena.size();
+        arena.resize(key_off + raw_key.size() + raw_value.size());
+        size_t key_len = decode(raw_key, arena.data() + key_off);
+        size_t val_off = key_off + key_len;
+        size_t val_len = decode(raw_value, arena.data() + val_off);
+        arena.resize(val_off + val_len);
+        index_entry(key_off, key_len, val_off, val_len);
+    }
+
+    /// Pre-sizes the arena for the given number of raw bytes.
+    void reserve(size_t bytes) { arena.reserve(bytes); }
+
+    [[nodiscard]] size_t size() const { return count; }
+    [[nodiscard]] bool empty() const { return count == 0; }
+
+    [[nodiscard]] const_iterator begin() const { return {this, 0}; }
+    [[nodiscard]] const_iterator end() const { return {this, count}; }
+
+private:
+    struct Entry {
+        uint32_t key_off = 0;
+        uint32_t key_len = 0;
+        uint32_t val_off = 0;
+        uint32_t val_len = 0;
+    };
+
+    std::string arena;                               ///< Decoded keys and values, back to back.
+    std::array<Entry, INLINE_CAPACITY> inline_entries{};
+    std::vector<Entry> overflow;                     ///< Entries past INLINE_CAPACITY.
+    std::vector<uint32_t> slots;                     ///< Hash table of entry index + 1 (0 is empty); built past INLINE_CAPACITY.
+    size_t count = 0;
+
+    [[nodiscard]] const Entry& entry_ref(size_t index) const {
+        return index < INLINE_CAPACITY ? inline_entries[index] : overflow[index - INLINE_CAPACITY];
+    }
+    [[nodiscard]] Entry& entry_ref(size_t index) {
+        return index < INLINE_CAPACITY ? inline_entries[index] : overflow[index - INLINE_CAPACITY];
+    }
+    [[nodiscard]] value_type entry_at(size_t index) const;
+    [[nodiscard]] size_t find_index(std::string_view key) const;
+    [[nodiscard]] const Entry* find(std::string_view key) const;
+    void index_entry(size_t key_off, size_t key_len, size_t val_off, size_t val_len);
+    void hash_entry(size_t index);
+    void rehash(size_t capacity);
+};
+
+/**
+ * @struct UploadedFile
+ * @brief A file part of a multipart/form-data request, spilled to a temporary file.
+ * The temporary file is deleted when the object is destroyed unless release() was called
+ * (e.g., after the handler renamed it into permanent storage).
+ */
+struct UploadedFile {
+    std::string field;                               ///< Form field name.
+    std::string filename;                            ///< Client-supplied file name (untrusted).
+    std::string content_type;                        ///< Client-supplied MIME type.
+    std::string temp_path;                           ///< Location of the spilled data on disk.
+    size_t size = 0;                                 ///< Number of bytes written.
+
+    UploadedFile() = default;
+    UploadedFile(UploadedFile&& other) noexcept;
+    UploadedFile& operator=(UploadedFile&& other) noexcept;
+    UploadedFile(const UploadedFile&) = delete;
+    UploadedFile& operator=(const UploadedFile&) = delete;
+    ~UploadedFile();
+
+    /// Keeps the file on disk when this object is destroyed.
+    void release() { temp_path.clear(); }
+};
+
 /**
  * @struct RequestInfo
  * @brief Encapsulates all parsed data from an incoming HTTP request.
@@ -19,10 +187,35 @@ constexpr size_t MAX_PAYLOAD_SIZE = 10485760;
 struct RequestInfo {
     std::string path;                                ///< The requested URI path.
     std::string query;                               ///< The raw query string.
-    std::map<std::string, std::string> params;       ///< Parsed key-value pairs from query/body.
+    ParamStore params;                               ///< Parsed key-value pairs from query/body.
     std::string method;                              ///< HTTP method (GET, POST, etc.).
+    HttpMethod method_id = HttpMethod::UNKNOWN;      ///< Parsed form of method used for dispatch.
     std::string body;                                ///< The raw request body.
+    std::shared_ptr<const JsonDocument> json;        ///< Parsed DOM of an application/json body, if any.
+    std::vector<UploadedFile> uploads;               ///< File parts of a multipart/form-data body.
+    BodyStream* body_stream = nullptr;               ///< Unread body, for routes registered with RouteOptions::stream_body.
+    std::string head;                                ///< Raw request line and header section.
     bool keep_alive = true;                          ///< Connection persistence flag.
+
+    /// Router captures for ":name" and "*name" segments. Values are views into path.
+    std::vector<std::pair<std::string_view, std::string_view>> path_params;
+
+    /**
+     * @brief Looks up a value captured by the router.
+     * @param name The parameter name as declared in the route pattern (without ':' or '*').
+     * @return std::string_view The captured value, or an empty view if absent.
+     */
+    [[nodiscard]] std::string_view path_param(std::string_view name) const;
+
+    /**
+     * @brief Looks up a request header by name (case-insensitive) in the raw head.
+     * @param name The header name without the colon (e.g., "Accept-Encoding").
+     * @return std::string_view The trimmed value of the first occurrence, or an empty view if absent.
+     */
+    [[nodiscard]] std::string_view header(std::string_view name) const;
+
+    /// Number of header lines with this name (case-insensitive); framing headers must not repeat.
+    [[nodiscard]] size_t header_count(std::string_view name) const;
 };
 
 /**
@@ -37,8 +230,28 @@ struct Response {
     std::map<std::string, std::string> headers;      ///< Additional HTTP headers.
     bool keep_alive = true;                          ///< Connection persistence flag.
 
+    /// Optional body producer. When set, body is ignored: the head is sent first and the
+    /// producer then writes the body incrementally as chunked transfer encoding.
+    std::function<void(ResponseWriter&)> stream;
+
+    /// Optional deferral, for answers that are not ready yet (e.g., long polling). The connection
+    /// is parked without a worker thread and this is called with a PendingResponse whose
+    /// complete() sends the real answer. If nobody completes it within defer_timeout, the rest of
+    /// this Response is sent as it is.
+    std::function<void(const std::shared_ptr<PendingResponse>&)> defer;
+    std::chrono::milliseconds defer_timeout{30000};  ///< How long a deferred response may stay pending.
+
+    /// Set on a 101 response by websocket_upgrade(): once the handshake is sent, the connection
+    /// becomes a WebSocket on the event loop and this is called with it.
+    std::function<void(const std::shared_ptr<WebSocket>&)> websocket;
+
+    /// Set by event_stream_response(): once the head is sent, the body continues as a chunked
+    /// Server-Sent Events stream on the event loop and this is called with it.
+    std::function<void(const std::shared_ptr<EventStream>&)> event_stream;
+
     /**
      * @brief Serializes the response object into a valid HTTP-formatted string.
+     * For a streaming response only the head is produced, announcing chunked encoding.
      * @return std::string The formatted HTTP response ready for socket transmission.
      */
     [[nodiscard]] std::string to_string() const;
@@ -52,9 +265,13 @@ struct Message {
     std::string user;
     std::string text;
     std::string timestamp;
+    int64_t id = 0;         ///< Primary key in the messages table; 0 until the message is stored.
 };
 
 /// Alias for callback functions that handle specific HTTP routes.
 using RouteHandler = std::function<Response(const RequestInfo&)>;
 
+/// Plain function handler used by compile-time route tables (no type erasure, no allocation).
+using RawRouteHandler = Response (*)(const RequestInfo&);
+
 #endif // COMMON_HPP
\ No newline at end of file
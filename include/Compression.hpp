@@ -0,0 +1,104 @@
+#ifndef COMPRESSION_HPP
+#define COMPRESSION_HPP
+#pragma once
+
+#include "Common.hpp"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <zlib.h>
+
+/**
+ * @enum ContentCoding
+ * @brief Response body encodings the server can produce.
+ */
+enum class ContentCoding : uint8_t {
+    IDENTITY,
+    GZIP,
+    DEFLATE  ///< The zlib format, which is what HTTP calls "deflate".
+};
+
+/**
+ * @brief Picks the best coding the client accepts from an Accept-Encoding header value.
+ * gzip is preferred over deflate at equal quality; codings with q=0 are never chosen.
+ */
+ContentCoding negotiate_encoding(std::string_view accept_encoding);
+
+/// The Content-Encoding token for a coding (empty for IDENTITY).
+std::string_view content_coding_name(ContentCoding coding);
+
+/**
+ * @brief True for textual MIME types that compress well. Images, archives, fonts and other
+ * already-compressed formats are excluded.
+ */
+bool is_compressible(std::string_view content_type);
+
+/**
+ * @class Deflater
+ * @brief A reusable zlib compression stream.
+ *
+ * deflateInit allocates about 256 KB of window and hash tables, which would dominate the cost of
+ * compressing a typical page. Each worker thread therefore keeps one Deflater per coding (see
+ * acquire()) and only resets it between responses.
+ */
+class Deflater {
+public:
+    static constexpr int LEVEL = 6;                  ///< zlib's default speed/ratio trade-off.
+
+    explicit Deflater(ContentCoding coding);
+    ~Deflater();
+
+    Deflater(const Deflater&) = delete;
+    Deflater& operator=(const Deflater&) = delete;
+
+    /**
+     * @brief Compresses input and appends the output to out.
+     * @param flush Z_NO_FLUSH to let zlib buffer, Z_SYNC_FLUSH to emit everything so far on a
+     * byte boundary, or Z_FINISH to end the stream (the Deflater is then reset for reuse).
+     * @return bool False if zlib reported an error.
+     */
+    bool compress(std::string_view input, std::string& out, int flush);
+
+    /**
+     * @brief Borrows this thread's cached Deflater for a coding, or a fresh one if it is in use.
+     * Return it with release().
+     */
+    static Deflater* acquire(ContentCoding coding);
+
+    /// Returns a Deflater obtained from acquire().
+    static void release(Deflater* deflater);
+
+private:
+    z_stream stream{};
+    ContentCoding coding;
+    bool ready = false;
+    bool busy = false;
+    bool cached = false;
+};
+
+/**
+ * @brief Compresses a handler's response in place if the request and response allow it.
+ *
+ * Buffered bodies smaller than min_size, incompressible MIME types, responses that already carry
+ * a Content-Encoding and bodies that would not shrink are left untouched. A streaming response
+ * is wrapped so its ResponseWriter compresses each chunk on the fly.
+ */
+void compress_response(const RequestInfo& req, Response& res, size_t min_size);
+
+/**
+ * @struct CompressResponses
+ * @brief Middleware layer applying compress_response() to every routed response.
+ * Place it inside ServerTiming so the reported duration includes the compression work.
+ */
+struct CompressResponses {
+    size_t min_size = 1024;                          ///< Below this, header and framing overhead eat the savings.
+
+    template <typename Next>
+    Response operator()(RequestInfo& req, Next&& next) const {
+        Response res = next(req);
+        compress_response(req, res, min_size);
+        return res;
+    }
+};
+
+#endif // COMPRESSION_HPP
@@ -0,0 +1,186 @@
+#ifndef DATABASE_HPP
+#define DATABASE_HPP
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <pqxx/pqxx>
+
+/**
+ * @class PoolTimeout
+ * @brief Thrown by ConnectionPool::acquire() when no connection became available in time.
+ */
+class PoolTimeout : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+/**
+ * @struct PoolMetrics
+ * @brief Lock-free counters describing pool behaviour, exported on /metrics.
+ */
+struct PoolMetrics {
+    std::atomic<uint64_t> checkouts{0};              ///< Successful acquire() calls.
+    std::atomic<uint64_t> checkout_timeouts{0};      ///< acquire() calls that gave up.
+    std::atomic<uint64_t> wait_us_total{0};          ///< Time spent inside acquire(), in microseconds.
+    std::atomic<uint64_t> connects{0};               ///< Connections opened.
+    std::atomic<uint64_t> connect_failures{0};       ///< Failed connection attempts.
+    std::atomic<uint64_t> discarded{0};              ///< Connections dropped as broken or failing a health check.
+};
+
+/**
+ * @struct PreparedStatement
+ * @brief A named SQL statement that every pooled connection prepares once.
+ */
+struct PreparedStatement {
+    std::string name;
+    std::string sql;
+};
+
+/**
+ * @class StatementRegistry
+ * @brief The set of prepared statements declared by the application.
+ *
+ * Handlers declare their statements at startup and then run them by name with exec_prepared(),
+ * so Postgres parses and plans each one once per connection instead of once per request.
+ * The registry only grows; a connection remembers how many entries it has already prepared and
+ * picks up later additions the next time it is checked out.
+ */
+class StatementRegistry {
+public:
+    /**
+     * @brief Declares a statement.
+     * @param name The name passed to exec_prepared().
+     * @param sql The statement text, with $1, $2, ... placeholders.
+     * @throws std::invalid_argument If the name is already registered with different SQL.
+     */
+    void add(std::string name, std::string sql);
+
+    /// Number of statements declared so far.
+    [[nodiscard]] size_t size() const;
+
+    /// Copies of the statements from index from on, for connections that prepare them their own way.
+    [[nodiscard]] std::vector<PreparedStatement> since(size_t from) const;
+
+    /**
+     * @brief Prepares the statements a connection has not seen yet.
+     * @param conn The connection.
+     * @param from How many statements the connection already has.
+     * @return size_t The new count to remember for the connection.
+     */
+    size_t prepare_on(pqxx::connection& conn, size_t from) const;
+
+private:
+    mutable std::mutex mutex;
+    std::deque<PreparedStatement> statements;        ///< Append-only, so a connection's count stays a valid prefix.
+};
+
+/**
+ * @class ConnectionPool
+ * @brief A bounded pool of PostgreSQL connections shared by all worker threads.
+ *
+ * Connections are opened lazily up to max_size and handed out most-recently-used first, so a
+ * quiet server keeps reusing the same warm backends. A connection that sat idle longer than
+ * idle_check is pinged before reuse, and one that comes back closed is dropped. Failed connects
+ * back off exponentially so a database outage does not turn into a connect storm; callers wait
+ * for at most checkout_timeout and then get a PoolTimeout. Every connection handed out has the
+ * registry's statements prepared.
+ */
+class ConnectionPool {
+public:
+    struct Options {
+        std::string url;                                             ///< libpq connection string.
+        size_t max_size = 8;                                         ///< Upper bound on open connections.
+        std::chrono::milliseconds checkout_timeout{2000};            ///< Longest acquire() may block.
+        std::chrono::milliseconds idle_check{30000};                 ///< Idle time after which a connection is pinged.
+        std::chrono::milliseconds backoff_initial{100};              ///< First delay after a failed connect.
+        std::chrono::milliseconds backoff_max{5000};                 ///< Cap for the doubling delay.
+    };
+
+private:
+    struct PooledConnection {
+        std::unique_ptr<pqxx::connection> conn;
+        size_t prepared = 0;                         ///< Registry entries already prepared on conn.
+        std::chrono::steady_clock::time_point idle_since;
+    };
+
+public:
+    /**
+     * @class Lease
+     * @brief Exclusive use of one pooled connection; returns it to the pool on destruction.
+     */
+    class Lease {
+    public:
+        Lease(Lease&& other) noexcept : pool(other.pool), slot(std::move(other.slot)) { other.pool = nullptr; }
+        Lease& operator=(Lease&&) = delete;
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+        ~Lease();
+
+        pqxx::connection& operator*() const { return *slot->conn; }
+        pqxx::connection* operator->() const { return slot->conn.get(); }
+
+        /// Drops the connection instead of returning it (e.g., after a protocol-level error).
+        void discard();
+
+    private:
+        friend class ConnectionPool;
+        Lease(ConnectionPool* pool, std::unique_ptr<PooledConnection> slot) : pool(pool), slot(std::move(slot)) {}
+
+        ConnectionPool* pool;
+        std::unique_ptr<PooledConnection> slot;
+    };
+
+    explicit ConnectionPool(Options options);
+    ~ConnectionPool();
+
+    ConnectionPool(const ConnectionPool&) = delete;
+    ConnectionPool& operator=(const ConnectionPool&) = delete;
+
+    /**
+     * @brief Checks out a connection, opening one if the pool is below its limit.
+     * @return Lease The connection, exclusively owned until the lease is destroyed.
+     * @throws PoolTimeout If none became available within checkout_timeout.
+     */
+    Lease acquire();
+
+    /// Statements prepared on every connection; declare them at startup.
+    StatementRegistry& statements() { return registry; }
+
+    /// Counters for monitoring.
+    [[nodiscard]] const PoolMetrics& metrics() const { return stats; }
+
+    /**
+     * @brief Renders the pool counters and gauges in the Prometheus text exposition format.
+     * @return std::string One "name value" line per metric.
+     */
+    [[nodiscard]] std::string to_prometheus() const;
+
+private:
+    Options options;
+    StatementRegistry registry;
+    mutable std::mutex mutex;
+    std::condition_variable available;
+    std::vector<std::unique_ptr<PooledConnection>> idle; ///< Used as a stack: the back is the warmest.
+    size_t open_count = 0;                           ///< Idle plus leased plus being opened.
+    std::chrono::steady_clock::time_point next_connect_at{};
+    std::chrono::milliseconds backoff{0};
+    std::string last_error;
+    PoolMetrics stats;
+
+    std::unique_ptr<PooledConnection> connect();
+    static bool healthy(pqxx::connection& conn);
+    Lease hand_out(std::unique_ptr<PooledConnection> slot);
+    void give_back(std::unique_ptr<PooledConnection> slot);
+    void forget();
+};
+
+#endif // DATABASE_HPP
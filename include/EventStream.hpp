@@ -0,0 +1,132 @@
+#ifndef EVENT_STREAM_HPP
+#define EVENT_STREAM_HPP
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include "Common.hpp"
+#include "Reactor.hpp"
+#include "FanOut.hpp"
+
+/**
+ * @brief Formats one Server-Sent Event.
+ * @param data The event data; each line becomes its own "data:" field.
+ * @param id The event id, sent back by the browser as Last-Event-ID on reconnect (0 for none).
+ * @return std::string The event text, terminated by a blank line.
+ */
+std::string sse_event(std::string_view data, int64_t id);
+
+/**
+ * @brief Wraps text in a chunk of the chunked transfer encoding, as written to an event stream.
+ */
+std::string sse_chunk(std::string_view text);
+
+class EventStream;
+
+/// Called on the event loop with a freshly opened stream, to replay history and subscribe it.
+using EventStreamOpen = std::function<void(const std::shared_ptr<EventStream>&)>;
+
+/**
+ * @brief Builds the response that opens a text/event-stream.
+ * @param on_open Runs once the head has been sent and the stream is on the event loop.
+ */
+Response event_stream_response(EventStreamOpen on_open);
+
+/**
+ * @class EventStream
+ * @brief A Server-Sent Events connection served by the event loop.
+ *
+ * The head goes out from the worker that handled the request; after that the socket belongs to
+ * the reactor, so an idle stream costs no thread and a fixed amount of memory: this object, the
+ * ring of its FanOut subscription and a heartbeat timer. Events are written as chunks as fast as
+ * the socket takes them. A comment line every heartbeat interval keeps proxies from timing the
+ * stream out and reveals dead peers, whose writes then fail; a write that makes no progress
+ * for a whole interval ends the stream too.
+ *
+ * send_event() and follow() run on the loop thread (e.g., from the open callback); close() may
+ * be called from any thread.
+ */
+class EventStream : public std::enable_shared_from_this<EventStream> {
+public:
+    struct Options {
+        std::chrono::seconds heartbeat{15};              ///< Silence after which a comment line is sent.
+        std::chrono::milliseconds retry{3000};           ///< Reconnect delay suggested to the browser.
+        size_t max_buffered = 256 * 1024;                ///< Unread backlog beyond which a new event ends the stream (replay exempt).
+    };
+
+    EventStream(Reactor& reactor, int socket, Options options);
+    ~EventStream();
+
+    EventStream(const EventStream&) = delete;
+    EventStream& operator=(const EventStream&) = delete;
+
+    /**
+     * @brief Queues one event, e.g., while replaying history on open (loop thread only).
+     * @param id The message id; broadcast frames up to it are skipped from then on.
+     */
+    void send_event(std::string_view data, int64_t id);
+
+    /**
+     * @brief Moves the browser's resume point (Last-Event-ID) without dispatching an event (loop thread only).
+     * Broadcast frames up to the id are skipped, as if they had been sent.
+     */
+    void resume_from(int64_t id);
+
+    /**
+     * @brief Subscribes the stream to a broadcast (loop thread only).
+     *
+     * Called from the open callback, frames are held back until the callback returns, so the
+     * callback can subscribe first and replay history afterwards without missing or repeating
+     * a message published in between.
+     * @param feed A FanOut whose encoder produces sse_chunk(sse_event(...)); it must outlive the stream.
+     * @param skip_through Frames for message ids up to this one are skipped (the client's Last-Event-ID).
+     */
+    void follow(FanOut& feed, int64_t skip_through = 0);
+
+    /// Ends the stream after what is queued has been written.
+    void close();
+
+    /// False once the stream is ending or ended.
+    [[nodiscard]] bool is_open() const { return open.load(std::memory_order_acquire); }
+
+private:
+    friend class HttpServer;
+
+    Reactor& reactor;
+    int socket;
+    Options options;
+
+    std::deque<std::shared_ptr<const std::string>> outbox;
+    size_t outbox_offset = 0;                        ///< Bytes of outbox.front() already written.
+    size_t buffered = 0;
+    bool writing = false;                            ///< EPOLLOUT is being watched.
+
+    std::atomic<bool> open{true};
+    bool closed = false;                             ///< Socket released (loop thread).
+    bool ending = false;                             ///< Final chunk queued.
+    bool opening = false;                            ///< Inside the open callback; broadcast frames wait.
+    bool wrote_since_heartbeat = false;
+    uint64_t heartbeat_timer = 0;
+
+    FanOut* feed_source = nullptr;
+    std::shared_ptr<FanOutSubscriber> feed;
+    int64_t skip_through = 0;                        ///< Highest message id already sent.
+
+    void start(const EventStreamOpen& on_open);
+    void handle_events(uint32_t events);
+    void queue(std::shared_ptr<const std::string> bytes);
+    bool flush();
+    bool refill();
+    void pump();
+    void end();
+    void schedule_heartbeat();
+    void shutdown();
+};
+
+#endif // EVENT_STREAM_HPP
@@ -0,0 +1,136 @@
+#ifndef FAN_OUT_HPP
+#define FAN_OUT_HPP
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Reactor.hpp"
+
+/**
+ * @enum SlowConsumerPolicy
+ * @brief What happens to a subscriber whose queue is full when a new frame is published.
+ */
+enum class SlowConsumerPolicy {
+    DROP,           ///< The new frame is skipped for that subscriber; it keeps what it has queued.
+    DISCONNECT,     ///< The subscriber is closed; it reconnects and catches up on its own.
+    COALESCE        ///< The queue is replaced by a single resync frame telling it to catch up.
+};
+
+/**
+ * @struct FanOutFrame
+ * @brief One encoded message, shared by every subscriber it is queued for.
+ */
+struct FanOutFrame {
+    int64_t id = 0;         ///< Id of the message it carries, if any (lets a subscriber skip what it already sent).
+    std::string bytes;      ///< The encoded frame, written to the socket as is.
+};
+
+using SharedFrame = std::shared_ptr<const FanOutFrame>;
+
+/**
+ * @class FanOutSubscriber
+ * @brief One receiver of a FanOut: a bounded ring of shared frames and the callbacks that drain it.
+ *
+ * The ring holds pointers, so a frame's bytes exist once no matter how many subscribers have
+ * it queued. The publisher pushes; the connection pops on the event loop when it can write.
+ */
+class FanOutSubscriber {
+public:
+    /**
+     * @param capacity Frames the ring holds before the slow-consumer policy applies.
+     * @param on_ready Called on the event loop when frames were queued; should pop() what it can write.
+     * @param on_overflow Called on the event loop under the DISCONNECT policy; should close the connection.
+     */
+    FanOutSubscriber(size_t capacity, std::function<void()> on_ready, std::function<void()> on_overflow);
+
+    /// Takes the oldest queued frame, or returns null if there is none.
+    SharedFrame pop();
+
+    /// Frames skipped or coalesced away because this subscriber fell behind.
+    [[nodiscard]] uint64_t dropped() const { return lost.load(std::memory_order_relaxed); }
+
+private:
+    friend class FanOut;
+
+    std::mutex mutex;                                ///< Shared only by the publisher and this subscriber's drain.
+    std::vector<SharedFrame> slots;
+    size_t head = 0;
+    size_t count = 0;
+    bool overflowed = false;                         ///< DISCONNECT policy triggered; nothing more is queued.
+
+    std::atomic<bool> scheduled{false};              ///< A drain is already posted to the event loop.
+    std::atomic<uint64_t> lost{0};
+    std::function<void()> on_ready;
+    std::function<void()> on_overflow;
+
+    enum class Push { QUEUED, FULL };
+    Push push(const SharedFrame& frame);
+    void replace_all(const SharedFrame& frame);
+};
+
+/**
+ * @class FanOut
+ * @brief Broadcasts messages to many live connections without letting one slow reader hold up the rest.
+ *
+ * publish() encodes a message once (e.g., into a WebSocket frame) and queues a pointer to it on
+ * every subscriber's ring, then posts a single task to the event loop that lets each subscriber
+ * with new frames write them. Publishing never touches a socket and never waits for one, so its
+ * cost is one pointer per subscriber regardless of payload size. A subscriber that does not keep
+ * up fills its ring, and the configured policy decides what it loses.
+ */
+class FanOut {
+public:
+    /// Turns a message and its id into the bytes a subscriber writes (a transport frame).
+    using Encoder = std::function<std::string(std::string_view payload, int64_t id)>;
+
+    struct Options {
+        size_t ring_capacity = 256;
+        SlowConsumerPolicy policy = SlowConsumerPolicy::COALESCE;
+        std::string resync_payload = R"({"resync":true})";  ///< Message left behind by COALESCE.
+        std::string name = "chat";                           ///< Metric label.
+    };
+
+    FanOut(Reactor& reactor, Encoder encode, Options options);
+
+    /// Creates a subscriber with this fan-out's ring capacity and registers it.
+    std::shared_ptr<FanOutSubscriber> subscribe(std::function<void()> on_ready, std::function<void()> on_overflow);
+
+    /// Unregisters a subscriber; frames already queued stay poppable.
+    void unsubscribe(const FanOutSubscriber& subscriber);
+
+    /**
+     * @brief Queues a message for every subscriber.
+     * @param payload The message; encoded once.
+     * @param id The message id carried along with the frame (0 if none).
+     * @return size_t The number of subscribers it was queued for.
+     */
+    size_t publish(std::string_view payload, int64_t id = 0);
+
+    /// Number of subscribers.
+    [[nodiscard]] size_t size() const;
+
+    /// Subscriber, publish and slow-consumer counters in the Prometheus text format.
+    [[nodiscard]] std::string to_prometheus() const;
+
+private:
+    Reactor& reactor;
+    Encoder encode;
+    Options options;
+    SharedFrame resync_frame;
+
+    mutable std::mutex mutex;                        ///< Guards the subscriber list; serializes publishers.
+    std::vector<std::shared_ptr<FanOutSubscriber>> subscribers;
+
+    std::atomic<uint64_t> published{0};
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<uint64_t> coalesced{0};
+    std::atomic<uint64_t> disconnected{0};
+};
+
+#endif // FAN_OUT_HPP
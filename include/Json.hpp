@@ -0,0 +1,237 @@
+#ifndef JSON_HPP
+#define JSON_HPP
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @enum JsonType
+ * @brief The kind of value a JsonValue refers to.
+ */
+enum class JsonType : uint8_t {
+    INVALID,  ///< Missing key, out-of-range index, or a value from a failed parse.
+    NUL,
+    BOOLEAN,
+    NUMBER,
+    STRING,
+    ARRAY,
+    OBJECT
+};
+
+class JsonDocument;
+
+/**
+ * @class JsonValue
+ * @brief A cheap, copyable view of one value inside a parsed JsonDocument.
+ *
+ * Navigation never allocates: containers know where their subtree ends on the tape, so
+ * skipping a nested value is a single index jump. Strings are kept as raw spans of the input
+ * and only unescaped when as_string() is called. A JsonValue must not outlive its document.
+ */
+class JsonValue {
+public:
+    JsonValue() = default;
+
+    [[nodiscard]] JsonType type() const;
+    [[nodiscard]] bool valid() const { return type() != JsonType::INVALID; }
+    explicit operator bool() const { return valid(); }
+
+    [[nodiscard]] bool is_null() const { return type() == JsonType::NUL; }
+    [[nodiscard]] bool is_object() const { return type() == JsonType::OBJECT; }
+    [[nodiscard]] bool is_array() const { return type() == JsonType::ARRAY; }
+    [[nodiscard]] bool is_string() const { return type() == JsonType::STRING; }
+    [[nodiscard]] bool is_number() const { return type() == JsonType::NUMBER; }
+
+    /**
+     * @brief The raw source text of a scalar (string contents without quotes, escapes intact).
+     * Containers return an empty view.
+     */
+    [[nodiscard]] std::string_view raw() const;
+
+    /// The unescaped string value (UTF-8), or the raw text for other scalars.
+    [[nodiscard]] std::string as_string() const;
+
+    /// The numeric value, or the fallback for non-numbers.
+    [[nodiscard]] double as_double(double fallback = 0.0) const;
+
+    /// The integral value (fractions are truncated), or the fallback for non-numbers.
+    [[nodiscard]] int64_t as_int(int64_t fallback = 0) const;
+
+    /// True only for the literal true.
+    [[nodiscard]] bool as_bool() const;
+
+    /// Number of members of an object or elements of an array; zero for scalars.
+    [[nodiscard]] size_t size() const;
+
+    /**
+     * @brief Looks up an object member by key (linear scan over the members).
+     * @return JsonValue The member, or an INVALID value if absent or this is not an object.
+     */
+    [[nodiscard]] JsonValue operator[](std::string_view key) const;
+
+    /**
+     * @brief Looks up an array element by position.
+     * @return JsonValue The element, or an INVALID value if out of range or this is not an array.
+     */
+    [[nodiscard]] JsonValue operator[](size_t index) const;
+
+    /**
+     * @class iterator
+     * @brief Walks the elements of an array or the members of an object.
+     * For objects, key() is the member's name and value() its value; for arrays key() is invalid.
+     */
+    class iterator {
+    public:
+        iterator(const JsonDocument* doc, uint32_t index, bool object) : doc(doc), index(index), object(object) {}
+
+        [[nodiscard]] JsonValue key() const;
+        [[nodiscard]] JsonValue value() const;
+        JsonValue operator*() const { return value(); }
+        iterator& operator++();
+        bool operator==(const iterator& other) const { return index == other.index; }
+        bool operator!=(const iterator& other) const { return index != other.index; }
+
+    private:
+        const JsonDocument* doc;
+        uint32_t index;
+        bool object;
+    };
+
+    [[nodiscard]] iterator begin() const;
+    [[nodiscard]] iterator end() const;
+
+private:
+    friend class JsonDocument;
+
+    JsonValue(const JsonDocument* doc, uint32_t index) : doc(doc), index(index) {}
+
+    const JsonDocument* doc = nullptr;
+    uint32_t index = 0;
+};
+
+/**
+ * @class JsonDocument
+ * @brief A two-stage JSON parser in the style of simdjson.
+ *
+ * Stage 1 classifies the input 64 bytes at a time with SIMD comparisons, resolves escaped
+ * quotes and string interiors with bit arithmetic, and records the offset of every structural
+ * character. Stage 2 walks only those offsets to validate the grammar and build a flat tape,
+ * which JsonValue navigates lazily. The document keeps its own copy of the input so values
+ * stay valid regardless of what happens to the original buffer.
+ */
+class JsonDocument {
+public:
+    /**
+     * @brief Parses a complete JSON text, replacing any previous contents.
+     *
+     * Objects and arrays may nest at most 512 levels deep; anything deeper fails to parse.
+     * @param json The input text.
+     * @return bool True on success; on failure root() is INVALID and error() explains why.
+     */
+    bool parse(std::string_view json);
+
+    /// The top-level value of the last successful parse.
+    [[nodiscard]] JsonValue root() const { return tape.empty() ? JsonValue() : JsonValue(this, 0); }
+
+    /// A short description of the last parse error, or an empty view.
+    [[nodiscard]] std::string_view error() const { return error_message; }
+
+private:
+    friend class JsonValue;
+
+    struct TapeEntry {
+        JsonType type = JsonType::INVALID;
+        bool escaped = false;      ///< String contains at least one backslash escape.
+        uint32_t offset = 0;       ///< Start of the raw text in source.
+        uint32_t length = 0;       ///< Length of the raw text in source.
+        uint32_t next = 0;         ///< Tape index just past this value's subtree.
+        uint32_t count = 0;        ///< Members or elements of a container.
+    };
+
+    std::string source;
+    std::unique_ptr<uint32_t[]> structurals;  ///< Offsets of structural bytes (left uninitialized on growth).
+    size_t structural_count = 0;
+    size_t structural_capacity = 0;
+    std::vector<TapeEntry> tape;
+    std::string error_message;
+
+    bool index_structurals();
+    bool build_tape();
+    bool fail(std::string_view message);
+};
+
+/**
+ * @class JsonWriter
+ * @brief Streams JSON text straight into a caller-owned buffer, typically Response::body.
+ *
+ * There is no intermediate DOM: each call appends its bytes immediately, commas and colons are
+ * inserted automatically, strings are escaped by copying runs of safe bytes in bulk, and numbers
+ * are formatted with std::to_chars (shortest round-trip form for doubles, no locale).
+ * @code
+ *     JsonWriter json(res.body);
+ *     json.begin_object().member("status", "healthy").member("uptime", 42).end_object();
+ * @endcode
+ */
+class JsonWriter {
+public:
+    explicit JsonWriter(std::string& out) : out(out) {}
+
+    JsonWriter& begin_object();
+    JsonWriter& end_object();
+    JsonWriter& begin_array();
+    JsonWriter& end_array();
+
+    /// Writes an object key; the next call writes its value.
+    JsonWriter& key(std::string_view name);
+
+    JsonWriter& value(std::string_view text);
+    JsonWriter& value(const char* text) { return value(std::string_view(text)); }
+    JsonWriter& value(const std::string& text) { return value(std::string_view(text)); }
+    JsonWriter& value(bool flag);
+    JsonWriter& value(double number);
+
+    template <typename T>
+        requires(std::is_integral_v<T> && !std::is_same_v<T, bool>)
+    JsonWriter& value(T number) {
+        if constexpr (std::is_signed_v<T>) {
+            return write_signed(static_cast<int64_t>(number));
+        } else {
+            return write_unsigned(static_cast<uint64_t>(number));
+        }
+    }
+    JsonWriter& null();
+
+    /// Writes a key and its value in one call.
+    template <typename T>
+    JsonWriter& member(std::string_view name, const T& val) { return key(name).value(val); }
+
+    /**
+     * @brief Splices an already-serialized JSON value (e.g., a cached fragment) as the next value.
+     * @param json Valid JSON text; it is copied verbatim.
+     */
+    JsonWriter& raw(std::string_view json);
+
+private:
+    std::string& out;
+    std::vector<uint8_t> has_items;  ///< One flag per open container: a value was already written.
+    bool after_key = false;
+
+    JsonWriter& write_signed(int64_t number);
+    JsonWriter& write_unsigned(uint64_t number);
+    void separator();
+    void write_string(std::string_view text);
+};
+
+/**
+ * @brief Decodes the contents of a JSON string literal (without quotes) into UTF-8.
+ * @param raw The raw text between the quotes.
+ * @return std::string The unescaped text; invalid escapes are copied verbatim.
+ */
+std::string json_unescape(std::string_view raw);
+
+#endif // JSON_HPP
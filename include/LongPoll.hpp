@@ -0,0 +1,71 @@
+#ifndef LONG_POLL_HPP
+#define LONG_POLL_HPP
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "MessageCache.hpp"
+#include "Server.hpp"
+
+/**
+ * @class LongPollHub
+ * @brief Holds long-poll requests until messages newer than the client's last id exist.
+ *
+ * A waiter is a deferred response (see Response::defer) together with the id it is waiting past,
+ * so it costs neither a worker thread nor a database query while it waits. The write path calls
+ * notify() with every new snapshot; each waiter that now has something to read is answered with
+ * its own delta, taken from the snapshot rather than from the database.
+ */
+class LongPollHub {
+public:
+    /// Builds the answer for a waiter from the messages it has not seen, oldest first.
+    using Renderer = std::function<Response(const std::vector<Message>& delta, bool has_more)>;
+
+    /**
+     * @param render Formats a delta; called outside the hub's lock.
+     * @param max_batch The most messages handed to one waiter; has_more is set beyond it.
+     */
+    LongPollHub(Renderer render, size_t max_batch);
+
+    /**
+     * @brief Returns the messages newer than an id, if the snapshot can tell.
+     * @param after_id The client's last seen id.
+     * @param delta Filled with up to max_batch messages, oldest first.
+     * @param has_more Set if the delta was cut short or may have a gap before the oldest cached message.
+     * @return bool False if nothing newer is cached.
+     */
+    bool delta(const MessageSnapshot& snapshot, int64_t after_id, std::vector<Message>& delta, bool& has_more) const;
+
+    /**
+     * @brief Parks a waiter, or answers it at once if the cache moved past after_id meanwhile.
+     *
+     * The check and the registration happen under the lock notify() takes, so a message
+     * published between the handler's own check and this call is never missed.
+     */
+    void wait(int64_t after_id, const std::shared_ptr<PendingResponse>& pending, const MessageCache& cache);
+
+    /// Answers every waiter that has something newer in the snapshot.
+    void notify(const MessageSnapshot& snapshot);
+
+    /// Number of parked waiters, including abandoned ones not swept yet.
+    [[nodiscard]] size_t waiting() const;
+
+private:
+    struct Waiter {
+        int64_t after_id;
+        std::shared_ptr<PendingResponse> pending;
+    };
+
+    Renderer render;
+    size_t max_batch;
+    mutable std::mutex mutex;
+    std::vector<Waiter> waiters;
+    size_t sweep_at = 64;                            ///< Size at which abandoned waiters are dropped.
+
+    void answer(const MessageSnapshot& snapshot, const Waiter& waiter) const;
+};
+
+#endif // LONG_POLL_HPP
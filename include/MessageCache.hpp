@@ -0,0 +1,70 @@
+#ifndef MESSAGE_CACHE_HPP
+#define MESSAGE_CACHE_HPP
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "Common.hpp"
+
+/**
+ * @struct MessageSnapshot
+ * @brief An immutable view of the most recent chat messages.
+ */
+struct MessageSnapshot {
+    std::vector<Message> messages;  ///< Oldest first, ordered by id.
+    uint64_t version = 0;           ///< Increases with every published change.
+    bool loaded = false;            ///< True once the history was read from the database.
+};
+
+/**
+ * @class MessageCache
+ * @brief Keeps the newest messages in memory so page renders skip the database.
+ *
+ * Read-copy-update: readers take a reference to the current snapshot and render from it for as
+ * long as they like. Writers build a new snapshot next to the old one and swap it in; the old one
+ * is freed when its last reader lets go. The only lock a reader touches guards the pointer
+ * itself and is held for a reference-count increment, never while a snapshot is being built.
+ * Writers serialize among themselves, which is cheap since they are the write queue and the
+ * cold-start load.
+ */
+class MessageCache {
+public:
+    /// @param capacity How many of the newest messages to keep.
+    explicit MessageCache(size_t capacity);
+
+    /// The current snapshot; never null.
+    [[nodiscard]] std::shared_ptr<const MessageSnapshot> snapshot() const {
+        std::lock_guard<std::mutex> lock(swap_mutex);
+        return current;
+    }
+
+    /**
+     * @brief Publishes stored messages.
+     *
+     * Messages are merged by id, so batches may arrive out of order or overlap with what is
+     * already cached (e.g., a cold-start load racing the first inserts, or a replica's own insert
+     * coming back as a notification) without duplicates.
+     * @param messages Messages with their database id and formatted timestamp.
+     * @return std::vector<Message> The messages that were not cached yet, ordered by id; the
+     *         same message is returned by at most one call, however many publish it.
+     */
+    std::vector<Message> publish(std::vector<Message> messages);
+
+    /**
+     * @brief Merges the history read from the database and marks the cache as loaded.
+     * @param messages The newest rows of the messages table, in any order.
+     */
+    void fill(std::vector<Message> messages);
+
+private:
+    size_t capacity;
+    std::mutex writer;                               ///< Serializes publishers for a whole merge.
+    mutable std::mutex swap_mutex;                   ///< Guards only the current pointer.
+    std::shared_ptr<const MessageSnapshot> current;
+
+    std::vector<Message> merge(std::vector<Message> messages, bool loaded);
+};
+
+#endif // MESSAGE_CACHE_HPP
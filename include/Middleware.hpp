@@ -0,0 +1,112 @@
+#ifndef MIDDLEWARE_HPP
+#define MIDDLEWARE_HPP
+#pragma once
+
+#include "Common.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <utility>
+
+/**
+ * @class Pipeline
+ * @brief A middleware chain composed at compile time.
+ *
+ * A layer is any copyable type providing
+ * @code
+ *     template <typename Next>
+ *     Response operator()(RequestInfo& req, Next&& next) const;
+ * @endcode
+ * where next(req) runs the rest of the chain and finally the route handler. Every hop is a
+ * distinct lambda type, so the compiler sees the whole chain and inlines it: a request pays
+ * no virtual call, no std::function call and no allocation per layer.
+ *
+ * Layers are shared by all worker threads, so operator() must be const and thread-safe.
+ *
+ * @tparam Layers The layers, outermost first.
+ */
+template <typename... Layers>
+class Pipeline;
+
+template <>
+class Pipeline<> {
+public:
+    template <typename Terminal>
+    Response run(RequestInfo& req, const Terminal& terminal) const { return terminal(req); }
+};
+
+template <typename Head, typename... Tail>
+class Pipeline<Head, Tail...> {
+public:
+    explicit Pipeline(Head head, Tail... tail) : head(std::move(head)), tail(std::move(tail)...) {}
+
+    template <typename Terminal>
+    Response run(RequestInfo& req, const Terminal& terminal) const {
+        return head(req, [this, &terminal](RequestInfo& inner) { return tail.run(inner, terminal); });
+    }
+
+private:
+    Head head;
+    Pipeline<Tail...> tail;
+};
+
+// ==========================================
+// BUILT-IN LAYERS
+// ==========================================
+
+/**
+ * @struct ServerTiming
+ * @brief Reports handler latency to the browser's dev tools via the Server-Timing header.
+ */
+struct ServerTiming {
+    template <typename Next>
+    Response operator()(RequestInfo& req, Next&& next) const {
+        auto start = std::chrono::steady_clock::now();
+        Response res = next(req);
+        auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start);
+        res.headers["Server-Timing"] = "app;dur=" + std::to_string(elapsed.count());
+        return res;
+    }
+};
+
+/**
+ * @struct HttpMetrics
+ * @brief Lock-free request counters shared by all worker threads.
+ */
+struct HttpMetrics {
+    std::atomic<uint64_t> requests{0};               ///< Requests that reached the pipeline.
+    std::atomic<uint64_t> responses_by_class[5]{};   ///< 1xx..5xx response counts.
+    std::atomic<uint64_t> latency_us_total{0};       ///< Sum of handler latencies in microseconds.
+
+    /**
+     * @brief Renders the counters in the Prometheus text exposition format.
+     * @return std::string One "name value" line per metric.
+     */
+    [[nodiscard]] std::string to_prometheus() const;
+};
+
+/**
+ * @struct CollectMetrics
+ * @brief Counts requests, response classes and cumulative latency into an HttpMetrics block.
+ */
+struct CollectMetrics {
+    HttpMetrics* metrics;
+
+    template <typename Next>
+    Response operator()(RequestInfo& req, Next&& next) const {
+        auto start = std::chrono::steady_clock::now();
+        Response res = next(req);
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+
+        metrics->requests.fetch_add(1, std::memory_order_relaxed);
+        metrics->latency_us_total.fetch_add(static_cast<uint64_t>(elapsed.count()), std::memory_order_relaxed);
+        int status_class = res.status_code / 100;
+        if (status_class >= 1 && status_class <= 5) {
+            metrics->responses_by_class[status_class - 1].fetch_add(1, std::memory_order_relaxed);
+        }
+        return res;
+    }
+};
+
+#endif // MIDDLEWARE_HPP
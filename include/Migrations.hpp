@@ -0,0 +1,34 @@
+#ifndef MIGRATIONS_HPP
+#define MIGRATIONS_HPP
+#pragma once
+
+#include <string>
+#include <vector>
+#include <pqxx/pqxx>
+
+/**
+ * @struct Migration
+ * @brief One versioned schema change.
+ */
+struct Migration {
+    int version;                ///< Unique and never reused; applied in ascending order.
+    std::string name;           ///< Short description recorded alongside the version.
+    std::string sql;            ///< One or more statements, run in a single transaction.
+};
+
+/**
+ * @brief Brings the schema up to date.
+ *
+ * Applied versions are recorded in a schema_migrations table. Every migration whose version is
+ * not recorded yet runs, in ascending order, each in its own transaction together with its
+ * record, so a failure leaves the schema at the last good version. A session-level advisory lock
+ * makes replicas that start together take turns instead of racing on the same DDL.
+ *
+ * @param conn A connection with no transaction open.
+ * @param migrations The full history, in any order.
+ * @return int The number of migrations applied by this call.
+ * @throws std::exception If a migration fails; later ones are not attempted.
+ */
+int run_migrations(pqxx::connection& conn, std::vector<Migration> migrations);
+
+#endif // MIGRATIONS_HPP
@@ -0,0 +1,127 @@
+#ifndef MULTIPART_HPP
+#define MULTIPART_HPP
+#pragma once
+
+#include "Common.hpp"
+#include <functional>
+#include <string>
+#include <string_view>
+
+/**
+ * @struct MultipartPartInfo
+ * @brief Headers of one part of a multipart/form-data body.
+ */
+struct MultipartPartInfo {
+    std::string name;                                ///< Content-Disposition "name" parameter.
+    std::string filename;                            ///< Content-Disposition "filename" parameter, if any.
+    std::string content_type = "text/plain";         ///< The part's Content-Type header.
+
+    /// True if the client sent this part as a file rather than a plain form field.
+    [[nodiscard]] bool is_file() const { return !filename.empty(); }
+};
+
+/**
+ * @class MultipartParser
+ * @brief Incremental multipart/form-data (RFC 7578) parser.
+ *
+ * The body may be fed in chunks of any size as they arrive from the socket. Part payloads are
+ * handed to the callbacks as soon as they are known not to contain the boundary, so memory use
+ * is bounded by the chunk size plus the boundary length, not by the part size. Boundaries are
+ * located with a Boyer-Moore-Horspool search prepared once per request.
+ */
+class MultipartParser {
+public:
+    struct Callbacks {
+        std::function<bool(const MultipartPartInfo&)> on_part_begin;  ///< Part headers were parsed; return false to abort.
+        std::function<bool(std::string_view)> on_part_data;           ///< Next payload slice; return false to abort.
+        std::function<void()> on_part_end;                            ///< Part payload is complete.
+    };
+
+    /**
+     * @brief Creates a parser for one request body.
+     * @param boundary The boundary parameter from the request's Content-Type header.
+     * @param callbacks Receivers for the parsed parts.
+     */
+    MultipartParser(std::string_view boundary, Callbacks callbacks);
+
+    // The searcher refers into the delimiter string
+    MultipartParser(const MultipartParser&) = delete;
+    MultipartParser& operator=(const MultipartParser&) = delete;
+
+    /**
+     * @brief Consumes the next slice of the body.
+     * @param chunk Raw body bytes.
+     * @return bool False if the body is malformed or a callback aborted; the parser is then unusable.
+     */
+    bool feed(std::string_view chunk);
+
+    /// True once the closing boundary has been seen.
+    [[nodiscard]] bool finished() const { return state == State::DONE; }
+
+    /// A short description of why feed() failed.
+    [[nodiscard]] std::string_view error() const { return error_message; }
+
+    /**
+     * @brief Extracts the boundary parameter from a multipart Content-Type header value.
+     * @return std::string The boundary (quotes removed), or an empty string if absent.
+     */
+    static std::string boundary_from_content_type(std::string_view content_type);
+
+private:
+    enum class State { PREAMBLE, AFTER_BOUNDARY, HEADERS, BODY, DONE, FAILED };
+
+    static constexpr size_t MAX_HEADER_BYTES = 16384;
+
+    std::string delimiter;                           ///< "\r\n--" + boundary
+    std::boyer_moore_horspool_searcher<std::string::const_iterator> searcher;
+    Callbacks callbacks;
+    State state = State::PREAMBLE;
+    std::string pending;                             ///< Bytes not yet consumed (partial boundary or headers).
+    MultipartPartInfo part;
+    std::string error_message;
+
+    size_t find_delimiter(std::string_view data) const;
+    bool parse_part_headers(std::string_view headers);
+    bool fail(std::string_view message);
+};
+
+/**
+ * @class MultipartFormReader
+ * @brief Collects a multipart/form-data body into a RequestInfo without buffering file parts.
+ *
+ * Plain fields are stored in RequestInfo::params. File parts are written to temporary files
+ * (in $UPLOAD_TMP_DIR, or /tmp) and recorded in RequestInfo::uploads.
+ */
+class MultipartFormReader {
+public:
+    /**
+     * @param boundary The boundary parameter from the request's Content-Type header.
+     * @param req The request to populate.
+     */
+    MultipartFormReader(std::string_view boundary, RequestInfo& req);
+    ~MultipartFormReader();
+
+    MultipartFormReader(const MultipartFormReader&) = delete;
+    MultipartFormReader& operator=(const MultipartFormReader&) = delete;
+
+    /// Consumes the next slice of the body; false on malformed input or I/O failure.
+    bool feed(std::string_view chunk) { return parser.feed(chunk); }
+
+    /// True once the whole body has been consumed.
+    [[nodiscard]] bool finished() const { return parser.finished(); }
+
+private:
+    RequestInfo& req;
+    MultipartParser parser;
+    std::string field_value;                         ///< Current in-memory field.
+    size_t field_bytes = 0;                          ///< Total bytes of plain fields so far.
+    int file_fd = -1;                                ///< Open temp file of the current file part.
+    UploadedFile* current_upload = nullptr;
+    MultipartPartInfo current;
+
+    bool begin_part(const MultipartPartInfo& info);
+    bool part_data(std::string_view data);
+    void end_part();
+};
+
+#endif // MULTIPART_HPP
@@ -0,0 +1,93 @@
+#ifndef NOTIFICATION_LISTENER_HPP
+#define NOTIFICATION_LISTENER_HPP
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @class NotificationListener
+ * @brief Receives PostgreSQL NOTIFY payloads on a channel, on a connection and thread of its own.
+ *
+ * LISTEN binds a channel to one session, so the listener cannot borrow from the pool: it opens a
+ * dedicated connection and blocks on its socket until a notification arrives. Nothing is polled;
+ * an idle listener is one sleeping thread and one idle backend.
+ *
+ * Notifications sent while no session was listening are lost, so after every (re)connect the
+ * listener calls on_listen once LISTEN is in effect; that is where the caller catches up on
+ * anything it may have missed. A lost connection is reopened with exponential backoff.
+ */
+class NotificationListener {
+public:
+    /**
+     * Called on the listener thread with the payloads that arrived together (e.g., one per row of a
+     * batch insert), in the order they were committed, so a burst is handled in one go.
+     */
+    using Handler = std::function<void(const std::vector<std::string>& payloads)>;
+
+    struct Options {
+        std::string url;                                             ///< libpq connection string.
+        std::string channel;                                         ///< The channel to LISTEN on.
+        std::chrono::milliseconds backoff_initial{500};              ///< First delay after a lost connection.
+        std::chrono::milliseconds backoff_max{30000};                ///< Cap for the doubling delay.
+    };
+
+    /**
+     * @param options Where and what to listen to.
+     * @param on_notify Handles the payloads; exceptions are logged and do not stop the listener.
+     * @param on_listen Runs after every successful LISTEN, before the first payload is handled.
+     */
+    NotificationListener(Options options, Handler on_notify, std::function<void()> on_listen);
+
+    /// Stops the listener thread.
+    ~NotificationListener();
+
+    NotificationListener(const NotificationListener&) = delete;
+    NotificationListener& operator=(const NotificationListener&) = delete;
+
+    /// Starts the listener thread; it connects in the background.
+    void start();
+
+    /// Closes the connection and joins the thread (waits up to about a second).
+    void stop();
+
+    /**
+     * @brief Ends the session after the current batch and reconnects, so on_listen runs again.
+     * For a handler that could not finish a batch and leaves it to the catch-up; call it from the handler.
+     */
+    void resync() { resync_requested.store(true, std::memory_order_relaxed); }
+
+    /// True while a session is listening.
+    [[nodiscard]] bool listening() const { return active.load(std::memory_order_relaxed); }
+
+    /// Connection state and notification counters in the Prometheus text format.
+    [[nodiscard]] std::string to_prometheus() const;
+
+private:
+    Options options;
+    Handler on_notify;
+    std::function<void()> on_listen;
+
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable wake;                    ///< Cuts a backoff short on stop().
+    std::atomic<bool> running{false};
+    std::atomic<bool> active{false};
+    std::atomic<bool> resync_requested{false};
+
+    std::atomic<uint64_t> received{0};
+    std::atomic<uint64_t> failed{0};                 ///< Payloads in batches whose handler threw.
+    std::atomic<uint64_t> reconnects{0};
+
+    void run();
+    void dispatch(const std::vector<std::string>& payloads);
+};
+
+#endif // NOTIFICATION_LISTENER_HPP
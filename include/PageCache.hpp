@@ -0,0 +1,50 @@
+#ifndef PAGE_CACHE_HPP
+#define PAGE_CACHE_HPP
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+
+/**
+ * @struct RenderedPage
+ * @brief A response body rendered once, in identity and gzip form.
+ */
+struct RenderedPage {
+    uint64_t version = 0;   ///< Version of the data it was rendered from.
+    std::string body;
+    std::string gzip;       ///< Empty if compression did not pay off.
+};
+
+/**
+ * @class PageCache
+ * @brief Holds the latest rendering of a page whose content is identified by a version number.
+ *
+ * The version must increase whenever the underlying data changes (e.g., MessageSnapshot::version).
+ * A request for a version that is already rendered costs a reference-count increment; the first
+ * request after a change renders and compresses the page while concurrent requests for the same
+ * version wait for that one rendering instead of repeating it.
+ */
+class PageCache {
+public:
+    using Renderer = std::function<std::string()>;
+
+    /**
+     * @brief Returns the page for a version, rendering it if the cache is older.
+     * @param version The version of the data the caller holds.
+     * @param render Produces the body; only called when a rebuild is needed.
+     * @return The cached page; may be newer than the requested version, never older.
+     */
+    std::shared_ptr<const RenderedPage> get(uint64_t version, const Renderer& render);
+
+private:
+    std::mutex build_mutex;                          ///< Serializes rebuilds.
+    mutable std::mutex swap_mutex;                   ///< Guards only the current pointer.
+    std::shared_ptr<const RenderedPage> current;
+
+    std::shared_ptr<const RenderedPage> load() const;
+};
+
+#endif // PAGE_CACHE_HPP
@@ -6,18 +6,36 @@
 #include <string>
 
 /**
- * @brief Parses a raw URL string into path, query, and key-value parameters.
+ * @brief Parses a raw URL string into path, query, and URL-decoded key-value parameters.
+ * The query is tokenized in a single pass and decoded directly into the flat ParamStore.
  * @param url The full URL string received in the HTTP request.
  * @return RequestInfo A populated struct with the extracted path and parameters.
  */
-RequestInfo parse_url(const std::string& url);
+RequestInfo parse_url(std::string_view url);
+
+/**
+ * @brief Maps a request-line method token to its HttpMethod slot.
+ * @param method The method token exactly as sent by the client (case-sensitive per RFC 9110).
+ * @return HttpMethod The matching method, or HttpMethod::UNKNOWN for extension methods.
+ */
+HttpMethod parse_method(std::string_view method);
 
 /**
  * @brief Decodes a URL-encoded string (e.g., converts "%20" to space).
  * @param str The encoded string.
  * @return std::string The decoded plain-text string.
  */
-std::string url_decode(const std::string& str);
+std::string url_decode(std::string_view str);
+
+/**
+ * @brief Decodes URL-encoded bytes into a caller-provided buffer without allocating.
+ * Runs free of '%' and '+' are copied 16 bytes at a time (SSE2/NEON), escapes are decoded
+ * through a hex lookup table, and malformed escapes are copied verbatim instead of throwing.
+ * @param src The encoded bytes.
+ * @param dst Output buffer of at least src.size() bytes; may equal src.data() to decode in place.
+ * @return size_t The number of decoded bytes written to dst.
+ */
+size_t url_decode_into(std::string_view src, char* dst);
 
 /**
  * @brief Parses an application/x-www-form-urlencoded body into the RequestInfo params.
@@ -27,7 +45,12 @@ std::string url_decode(const std::string& str);
 void parse_form_body(const std::string& form_body, RequestInfo& info);
 
 /**
- * @brief Parses a JSON body into the RequestInfo params using a simple state machine.
+ * @brief Parses a JSON body into a navigable document and flattens it into the RequestInfo params.
+ * The document is stored in info.json. Scalars become params keyed by their dotted path
+ * (e.g., {"user": {"name": "x"}, "tags": ["a"]} yields "user.name" and "tags.0"); strings are
+ * unescaped and other scalars keep their source text. Only the first 1000 scalars, no more than
+ * 32 levels deep, are flattened; the rest is reachable through info.json alone. Malformed JSON
+ * leaves info untouched.
  * @param body The raw JSON string.
  * @param info The RequestInfo object to populate with parsed key-value pairs.
  */
@@ -0,0 +1,271 @@
+#ifndef PIPELINE_HPP
+#define PIPELINE_HPP
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include <libpq-fe.h>
+#include "Database.hpp"
+
+/**
+ * @class PipelineError
+ * @brief Thrown when a pipelined connection fails as a whole (lost, or out of step with the server).
+ * A statement the server rejects is not an exception; its PipelineResult reports the error.
+ */
+class PipelineError : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+/**
+ * @class PipelineResult
+ * @brief The outcome of one pipelined statement: its rows, or the error that stopped it.
+ */
+class PipelineResult {
+public:
+    /// True if the statement ran; false if it failed or was skipped after an earlier failure in its transaction.
+    [[nodiscard]] bool ok() const;
+
+    /// The server's error message (or why the statement was skipped), or an empty view.
+    [[nodiscard]] std::string_view error() const;
+
+    /// The five-character SQLSTATE of a failed statement (e.g., "22021"), or an empty view.
+    [[nodiscard]] std::string_view sqlstate() const;
+
+    /// Number of rows returned.
+    [[nodiscard]] size_t size() const;
+
+    /// The text of one field; valid while the result lives.
+    [[nodiscard]] std::string_view value(size_t row, int column) const;
+
+    [[nodiscard]] std::string as_string(size_t row, int column) const { return std::string(value(row, column)); }
+    [[nodiscard]] int64_t as_int(size_t row, int column) const;
+
+private:
+    friend class QueryPipeline;
+
+    explicit PipelineResult(PGresult* result) : result(result, PQclear) {}
+
+    std::shared_ptr<PGresult> result;
+};
+
+/// Counters shared by the connections of one PipelinePool.
+struct PipelineMetrics {
+    std::atomic<uint64_t> round_trips{0};            ///< Pipelines run.
+    std::atomic<uint64_t> statements{0};             ///< Statements sent through them.
+    std::atomic<uint64_t> failed_statements{0};      ///< Statements rejected or skipped by the server.
+};
+
+/**
+ * @class PipelineConnection
+ * @brief A libpq connection kept in pipeline mode, with the registry's statements prepared.
+ *
+ * The socket is non-blocking, so queuing never stalls on a full send buffer while the server is
+ * busy writing results nobody reads yet; libpq flushes and reads in turn while results are
+ * collected.
+ */
+class PipelineConnection {
+public:
+    /// Connects and enters pipeline mode. @throws PipelineError If either fails.
+    explicit PipelineConnection(const std::string& url);
+    ~PipelineConnection();
+
+    PipelineConnection(const PipelineConnection&) = delete;
+    PipelineConnection& operator=(const PipelineConnection&) = delete;
+
+    /// False once the connection is lost or a pipeline on it failed.
+    [[nodiscard]] bool is_open() const;
+
+    /**
+     * @brief Prepares the registry entries from index from on, all in one round trip.
+     * @return size_t The new count to remember for the connection.
+     * @throws PipelineError If a statement cannot be prepared.
+     */
+    size_t prepare(const StatementRegistry& registry, size_t from);
+
+private:
+    friend class QueryPipeline;
+    friend class PipelinePool;
+
+    PGconn* conn;
+    bool broken = false;
+    PipelineMetrics* metrics = nullptr;
+};
+
+/**
+ * @class QueryPipeline
+ * @brief Statements queued on one connection and sent together, their results read in one round trip.
+ *
+ * Nothing goes out until run(), which appends a sync point, sends everything and waits once for
+ * all the answers. Statements between two sync points form one implicit transaction: they commit
+ * together, and after an error the rest of that segment is skipped. sync() starts a new segment,
+ * so independent writes (e.g., retries of single rows) can share a round trip without sharing a
+ * fate. An explicit BEGIN ... COMMIT works as usual.
+ *
+ * The connection must stay leased for the lifetime of the pipeline.
+ */
+class QueryPipeline {
+public:
+    explicit QueryPipeline(PipelineConnection& conn) : conn(conn) {}
+
+    /// Runs and discards whatever is still queued, so the connection is left idle.
+    ~QueryPipeline();
+
+    QueryPipeline(const QueryPipeline&) = delete;
+    QueryPipeline& operator=(const QueryPipeline&) = delete;
+
+    /**
+     * @brief Queues a prepared statement from the registry.
+     * @param args Parameters, sent as text: strings as they are, numbers formatted.
+     * @return size_t The statement's index in the results of run().
+     */
+    template <typename... Args>
+    size_t exec_prepared(const std::string& name, const Args&... args) {
+        return send(name, {to_param(args)...}, true);
+    }
+
+    /// Queues a PREPARE; its result tells whether the statement was accepted.
+    size_t prepare(const std::string& name, const std::string& sql);
+
+    /// Queues one SQL statement with $1, $2, ... placeholders; returns its index in the results.
+    template <typename... Args>
+    size_t exec_params(const std::string& sql, const Args&... args) {
+        return send(sql, {to_param(args)...}, false);
+    }
+
+    /// Ends the current implicit transaction; what follows commits or fails on its own.
+    void sync();
+
+    /// Number of statements queued.
+    [[nodiscard]] size_t size() const { return statements; }
+
+    /**
+     * @brief Sends the queued statements and reads every result.
+     * @return std::vector<PipelineResult> One result per statement, in the order they were queued.
+     * @throws PipelineError If the connection fails; it is then marked broken.
+     */
+    std::vector<PipelineResult> run();
+
+private:
+    enum class Step : uint8_t { STATEMENT, SYNC };
+
+    PipelineConnection& conn;
+    std::vector<Step> steps;
+    size_t statements = 0;
+
+    template <typename T>
+    static std::string to_param(const T& value) {
+        if constexpr (std::is_arithmetic_v<T>) {
+            return std::to_string(value);
+        } else {
+            return std::string(value);
+        }
+    }
+
+    size_t send(const std::string& command, const std::vector<std::string>& params, bool prepared);
+    size_t queued(int sent);
+    [[noreturn]] void fail(const std::string& what);
+};
+
+/**
+ * @class PipelinePool
+ * @brief A bounded pool of pipelined connections, with the same statements as the ConnectionPool.
+ *
+ * Kept apart from the ConnectionPool because libpqxx does not lend out its libpq handle. It is
+ * meant for the callers that send several statements at once (the write-behind queue, batch
+ * lookups), so it stays small. Connections open lazily and are reused most-recently-used first;
+ * one that sat idle longer than idle_check is pinged before reuse and dropped if the ping fails.
+ * Failed connects back off exponentially, and acquire() gives up after checkout_timeout.
+ */
+class PipelinePool {
+public:
+    struct Options {
+        std::string url;                                             ///< libpq connection string.
+        size_t max_size = 4;                                         ///< Upper bound on open connections.
+        std::chrono::milliseconds checkout_timeout{2000};            ///< Longest acquire() may block.
+        std::chrono::milliseconds idle_check{30000};                 ///< Idle time after which a connection is pinged.
+        std::chrono::milliseconds backoff_initial{100};              ///< First delay after a failed connect.
+        std::chrono::milliseconds backoff_max{5000};                 ///< Cap for the doubling delay.
+    };
+
+private:
+    struct PooledPipeline {
+        std::unique_ptr<PipelineConnection> conn;
+        size_t prepared = 0;                         ///< Registry entries already prepared on conn.
+        std::chrono::steady_clock::time_point idle_since;
+    };
+
+public:
+    /**
+     * @class Lease
+     * @brief Exclusive use of one pipelined connection; returns it to the pool on destruction.
+     */
+    class Lease {
+    public:
+        Lease(Lease&& other) noexcept : pool(other.pool), slot(std::move(other.slot)) { other.pool = nullptr; }
+        Lease& operator=(Lease&&) = delete;
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+        ~Lease();
+
+        PipelineConnection& operator*() const { return *slot->conn; }
+
+    private:
+        friend class PipelinePool;
+        Lease(PipelinePool* pool, std::unique_ptr<PooledPipeline> slot) : pool(pool), slot(std::move(slot)) {}
+
+        PipelinePool* pool;
+        std::unique_ptr<PooledPipeline> slot;
+    };
+
+    /**
+     * @param options Size and timeouts.
+     * @param registry The statements to prepare on every connection (normally the ConnectionPool's).
+     */
+    PipelinePool(Options options, StatementRegistry& registry);
+    ~PipelinePool();
+
+    PipelinePool(const PipelinePool&) = delete;
+    PipelinePool& operator=(const PipelinePool&) = delete;
+
+    /**
+     * @brief Checks out a connection, opening one if the pool is below its limit.
+     * @throws PoolTimeout If none became available within checkout_timeout.
+     */
+    Lease acquire();
+
+    /// Statements prepared on every connection; shared with the ConnectionPool.
+    StatementRegistry& statements() { return registry; }
+
+    /// Pool gauges and pipeline counters in the Prometheus text format.
+    [[nodiscard]] std::string to_prometheus() const;
+
+private:
+    Options options;
+    StatementRegistry& registry;
+    PipelineMetrics stats;
+
+    mutable std::mutex mutex;
+    std::condition_variable available;
+    std::vector<std::unique_ptr<PooledPipeline>> idle; ///< Used as a stack: the back is the warmest.
+    size_t open_count = 0;                           ///< Idle plus leased plus being opened.
+    std::chrono::steady_clock::time_point next_connect_at{};
+    std::chrono::milliseconds backoff{0};
+    std::string last_error;
+    std::atomic<uint64_t> connect_failures{0};
+
+    static bool healthy(PipelineConnection& conn);
+    Lease hand_out(std::unique_ptr<PooledPipeline> slot);
+    void give_back(std::unique_ptr<PooledPipeline> slot);
+};
+
+#endif // PIPELINE_HPP
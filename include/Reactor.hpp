@@ -0,0 +1,100 @@
+#ifndef REACTOR_HPP
+#define REACTOR_HPP
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * @class Reactor
+ * @brief A single-threaded epoll event loop for connections that are idle most of the time.
+ *
+ * Worker threads block on one socket each, which is right for a request that is being handled
+ * but wasteful for one that is only waiting (a long poll, a push channel). Such sockets are
+ * handed to the reactor instead: one thread watches all of them and runs a callback when one
+ * becomes readable, closes, or reaches a deadline. Callbacks run on the loop thread and must not
+ * block; real work is handed back to the worker pool.
+ *
+ * post() may be called from any thread. Everything else (watch, unwatch, timers) must run on the
+ * loop thread, i.e., from a callback or a posted task.
+ */
+class Reactor {
+public:
+    using Task = std::function<void()>;
+    using EventHandler = std::function<void(uint32_t events)>;
+    using Clock = std::chrono::steady_clock;
+
+    Reactor();
+    ~Reactor();
+
+    Reactor(const Reactor&) = delete;
+    Reactor& operator=(const Reactor&) = delete;
+
+    /// Starts the loop thread.
+    void start();
+
+    /// Stops the loop thread; pending tasks and timers are dropped.
+    void stop();
+
+    /// Runs a task on the loop thread. Thread-safe; tasks run in the order they were posted.
+    void post(Task task);
+
+    /**
+     * @brief Watches a file descriptor (loop thread only).
+     * @param fd The descriptor; the caller keeps ownership and must unwatch() before closing it.
+     * @param events EPOLLIN, EPOLLOUT, EPOLLRDHUP, ... (level-triggered).
+     * @param handler Called with the ready events.
+     */
+    void watch(int fd, uint32_t events, EventHandler handler);
+
+    /// Changes the events of a watched descriptor (loop thread only).
+    void modify(int fd, uint32_t events);
+
+    /// Stops watching a descriptor (loop thread only). Safe to call from the descriptor's own handler.
+    void unwatch(int fd);
+
+    /**
+     * @brief Runs a task at a deadline (loop thread only).
+     * @return uint64_t An id for cancel_timer().
+     */
+    uint64_t add_timer(Clock::time_point when, Task task);
+
+    /// Cancels a timer that has not fired yet (loop thread only).
+    void cancel_timer(uint64_t id);
+
+    /// Number of watched descriptors.
+    [[nodiscard]] size_t watched() const { return watch_count.load(std::memory_order_relaxed); }
+
+private:
+    int epoll_fd = -1;
+    int wake_fd = -1;                                ///< eventfd that interrupts epoll_wait for posted tasks.
+    std::thread loop;
+    std::atomic<bool> running{false};
+
+    std::mutex task_mutex;
+    std::vector<Task> tasks;
+
+    // Shared so a handler that unwatches its own descriptor is not destroyed while running
+    std::unordered_map<int, std::shared_ptr<EventHandler>> handlers;
+    std::atomic<size_t> watch_count{0};
+
+    std::map<std::pair<Clock::time_point, uint64_t>, Task> timers;
+    std::unordered_map<uint64_t, Clock::time_point> timer_deadlines;
+    uint64_t next_timer_id = 1;
+
+    void run();
+    void run_tasks();
+    void run_timers();
+    int next_timeout_ms() const;
+};
+
+#endif // REACTOR_HPP
@@ -0,0 +1,78 @@
+#ifndef RESPONSE_WRITER_HPP
+#define RESPONSE_WRITER_HPP
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+class Deflater;
+enum class ContentCoding : uint8_t;
+
+/**
+ * @brief Writes all of data to a socket, retrying partial sends.
+ * @return bool False if the peer went away.
+ */
+bool send_all(int socket, std::string_view data);
+
+/**
+ * @class ResponseWriter
+ * @brief Sends a streaming response body with "Transfer-Encoding: chunked".
+ *
+ * Handed to Response::stream after the status line and headers are on the wire. Small writes
+ * are coalesced into one chunk of about FLUSH_THRESHOLD bytes; larger ones go out directly
+ * without being copied. flush() forces buffered output onto the wire, e.g., to let the browser
+ * start rendering while the rest of the page is still being produced.
+ *
+ * With set_compression(), bytes pass through a deflate stream before being framed, and flush()
+ * performs a zlib sync flush so the client can decode everything sent so far.
+ */
+class ResponseWriter {
+public:
+    static constexpr size_t FLUSH_THRESHOLD = 16384; ///< Buffered bytes that trigger a chunk.
+
+    /// @param socket The client socket; its response head must already have been sent.
+    explicit ResponseWriter(int socket) : socket(socket) {}
+    ~ResponseWriter();
+
+    ResponseWriter(const ResponseWriter&) = delete;
+    ResponseWriter& operator=(const ResponseWriter&) = delete;
+
+    /**
+     * @brief Compresses everything written from now on. Must be called before the first write,
+     * and only when the response head announced the matching Content-Encoding.
+     */
+    void set_compression(ContentCoding coding);
+
+    /**
+     * @brief Appends body bytes.
+     * @return bool False once the client has gone away; producers should stop early.
+     */
+    bool write(std::string_view data);
+
+    /// Sends everything buffered so far as one chunk.
+    bool flush();
+
+    /// Flushes and sends the terminating zero-length chunk. Called by the server after the producer returns.
+    bool finish();
+
+    /// True if a send failed (client disconnected or timed out).
+    [[nodiscard]] bool failed() const { return error; }
+
+    /// Body bytes accepted so far (before compression and chunk framing).
+    [[nodiscard]] size_t bytes_written() const { return total; }
+
+private:
+    int socket;
+    std::string buffer;
+    size_t total = 0;
+    bool error = false;
+    bool finished = false;
+    Deflater* deflater = nullptr;                    ///< Borrowed per-thread compressor, if compressing.
+
+    bool send_chunk(std::string_view data);
+    bool fail();
+};
+
+#endif // RESPONSE_WRITER_HPP
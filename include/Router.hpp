@@ -0,0 +1,111 @@
+#ifndef ROUTER_HPP
+#define ROUTER_HPP
+#pragma once
+
+#include "Common.hpp"
+#include <array>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @struct RouteOptions
+ * @brief Per-route request handling settings, fixed at registration time.
+ */
+struct RouteOptions {
+    /// Hand the body to the handler through RequestInfo::body_stream as it arrives,
+    /// instead of buffering it into RequestInfo::body first.
+    bool stream_body = false;
+
+    /// Largest accepted body in bytes; larger requests are answered with 413 before any of the
+    /// body is read. Unset means MAX_PAYLOAD_SIZE (MAX_UPLOAD_SIZE for multipart uploads).
+    std::optional<size_t> max_body;
+};
+
+/**
+ * @struct RouteMatch
+ * @brief The outcome of a single router lookup.
+ */
+struct RouteMatch {
+    const RouteHandler* handler = nullptr;           ///< Dynamic handler for the request method, or nullptr.
+    RawRouteHandler direct = nullptr;                ///< Compile-time table handler, or nullptr.
+    uint16_t allowed_methods = 0;                    ///< Bitmask of HttpMethod slots registered on the path.
+    const RouteOptions* options = nullptr;           ///< Settings of the matched handler, or nullptr for defaults.
+
+    /// True when a handler exists for the request method.
+    [[nodiscard]] bool has_handler() const { return handler != nullptr || direct != nullptr; }
+
+    /// True when the path is known to the table that produced this match.
+    [[nodiscard]] bool path_found() const { return allowed_methods != 0; }
+
+    /// True when the path exists but has no handler for the requested method (HTTP 405).
+    [[nodiscard]] bool method_not_allowed() const { return !has_handler() && allowed_methods != 0; }
+
+    /// Calls whichever handler was matched. Requires has_handler().
+    Response invoke(const RequestInfo& req) const { return direct ? direct(req) : (*handler)(req); }
+};
+
+/// Lookup function exported by a StaticRouteTable instantiation.
+using StaticRouteLookup = RouteMatch (*)(HttpMethod, std::string_view);
+
+/**
+ * @class Router
+ * @brief Compressed radix tree mapping URI paths to per-method route handlers.
+ *
+ * Patterns are written with or without the leading slash and support two kinds of capture:
+ *  - ":name" matches one non-empty path segment (up to the next '/').
+ *  - "*name" matches the remainder of the path and must be the final segment.
+ *
+ * Static edges always win over captures; a capture is only tried when the static branch
+ * does not lead to a registered route. Captured values are stored in RequestInfo::path_params
+ * as views into RequestInfo::path, so a lookup performs no allocation for static routes.
+ */
+class Router {
+public:
+    Router();
+    ~Router();
+
+    Router(const Router&) = delete;
+    Router& operator=(const Router&) = delete;
+
+    /**
+     * @brief Registers a handler for one method on a path pattern.
+     * @param method The method slot to fill.
+     * @param pattern The path pattern (e.g., "/api/users/:id").
+     * @param handler The function to execute when the route is hit.
+     * @param options Body streaming and size limit settings for this handler.
+     * @throws std::invalid_argument If the pattern conflicts with an existing capture.
+     */
+    void add(HttpMethod method, std::string_view pattern, const RouteHandler& handler, const RouteOptions& options = {});
+
+    /**
+     * @brief Registers a handler for every method on a path pattern.
+     * @param pattern The path pattern.
+     * @param handler The function to execute for any request method.
+     */
+    void add_any(std::string_view pattern, const RouteHandler& handler);
+
+    /**
+     * @brief Resolves a request path in a single tree walk.
+     * @param method The parsed request method.
+     * @param req The request; its path is matched and path_params receives any captures.
+     * @return RouteMatch The handler (if any) and the methods registered on the matched path.
+     */
+    RouteMatch match(HttpMethod method, RequestInfo& req) const;
+
+    /**
+     * @brief Formats an Allow header value (e.g., "GET, POST") from a RouteMatch bitmask.
+     */
+    static std::string format_allow(uint16_t allowed_methods);
+
+private:
+    struct Node;
+
+    std::unique_ptr<Node> root;
+
+    Node* insert(std::string_view pattern);
+};
+
+#endif // ROUTER_HPP
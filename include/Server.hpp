@@ -3,6 +3,13 @@
 #pragma once
 
 #include "Common.hpp"
+#include "Router.hpp"
+#include "Middleware.hpp"
+#include "Reactor.hpp"
+#include "WebSocket.hpp"
+#include "EventStream.hpp"
+#include <atomic>
+#include <memory>
 #include <vector>
 #include <queue>
 #include <thread>
@@ -10,6 +17,45 @@
 #include <map>
 #include <string>
 
+class HttpServer;
+
+/**
+ * @class PendingResponse
+ * @brief A request whose answer is not ready yet (see Response::defer).
+ *
+ * While pending, the connection is parked on the server's event loop and holds no worker thread.
+ * Whoever has the answer calls complete() from any thread; a worker then sends it and carries on
+ * with the connection's next request. If the client disconnects first, the response is dropped;
+ * if the deadline passes, the handler's original Response is sent instead.
+ */
+class PendingResponse : public std::enable_shared_from_this<PendingResponse> {
+public:
+    /**
+     * @brief Sends the answer. Only the first of complete(), the timeout and a disconnect counts.
+     * @param res The response; defer and stream are ignored.
+     * @return bool False if the request was already answered or abandoned.
+     */
+    bool complete(Response res);
+
+    /// True once answered or abandoned; waiters may drop their reference.
+    [[nodiscard]] bool finished() const { return done.load(std::memory_order_acquire); }
+
+private:
+    friend class HttpServer;
+
+    PendingResponse(HttpServer* server, int socket, std::string buffer, RequestInfo req, Response fallback)
+        : server(server), socket(socket), buffer(std::move(buffer)), req(std::move(req)), fallback(std::move(fallback)) {}
+
+    HttpServer* server;
+    int socket;
+    std::string buffer;                              ///< Bytes read past the request, kept for the next one.
+    RequestInfo req;                                 ///< Method, path and keep-alive of the parked request.
+    Response fallback;                               ///< Sent on timeout.
+    Response answer;                                 ///< Set by complete().
+    uint64_t timer = 0;                              ///< Timeout on the event loop.
+    std::atomic<bool> done{false};
+};
+
 /**
  * @class HttpServer
  * @brief A multi-threaded HTTP server utilizing a Thread Pool architecture.
@@ -34,32 +80,76 @@ public:
     void start();
 
     /**
-     * @brief Registers a custom callback handler for a specific URI path.
-     * @param path The URI path (e.g., "/api/data").
+     * @brief Registers a custom callback handler for a specific URI path, for every method.
+     * @param path The URI path or pattern (e.g., "/api/data", "/api/users/:id").
      * @param handler The function to execute when the route is hit.
      */
  void add_route(const std::string& path, const RouteHandler& handler);
 
+    /**
+     * @brief Registers a callback handler for a single method on a URI path or pattern.
+     * Requests to the path with an unregistered method receive 405 Method Not Allowed.
+     * @param method The HTTP method slot to fill.
+     * @param path The URI path or pattern (e.g., "/api/users/:id").
+     * @param handler The function to execute when the route is hit.
+     * @param options Opt-in body streaming and a per-route body size limit.
+     */
+ void add_route(HttpMethod method, const std::string& path, const RouteHandler& handler, const RouteOptions& options = {});
+
+    /**
+     * @brief Installs a compile-time route table that is consulted before the dynamic router.
+     * @tparam Table A StaticRouteTable instantiation (see StaticRoutes.hpp).
+     */
+    template <typename Table>
+    void set_static_routes() { static_routes = &Table::match; }
+
+    /**
+     * @brief Wraps every routed request in a middleware chain.
+     * The layers are composed into one Pipeline at startup, so the whole chain costs a single
+     * indirect call per request regardless of how many layers it contains.
+     * @param layers The layers, outermost first (see Middleware.hpp).
+     */
+    template <typename... Layers>
+    void use_middleware(Layers... layers)
+    {
+        pipeline = [this, chain = Pipeline<Layers...>(std::move(layers)...)](RequestInfo& req, const RouteMatch& match) {
+            return chain.run(req, [this, &match](RequestInfo& inner) { return dispatch(inner, match); });
+        };
+    }
+
     /**
      * @brief Gracefully terminates the server, joining all threads and closing sockets.
      */
     void stop();
 
+    /// The event loop serving parked connections and WebSockets, for components that feed them (e.g., FanOut).
+    Reactor& event_loop() { return reactor; }
+
 private:
     int port;
     int server_fd;
     int thread_count;
 
+    /// A connection waiting for a worker: new, or resuming with a completed deferred response.
+    struct ClientTask {
+        int socket;
+        std::shared_ptr<PendingResponse> resumed;
+    };
+
     // Concurrency Primitives
     std::vector<std::thread> thread_pool;
-    std::queue<int> task_queue;                ///< Queue of client socket file descriptors
+    std::queue<ClientTask> task_queue;         ///< Queue of client connections
     std::mutex queue_mutex;                    ///< Protects access to the task_queue
     std::condition_variable cv;                ///< Notifies worker threads of new tasks
 
     // CRITICAL: Must be atomic to prevent data races during shutdown
     std::atomic<bool> stop_server;
 
-    std::map<std::string, RouteHandler> routes;
+    Reactor reactor;                           ///< Watches parked connections and WebSockets without tying up workers
+
+    Router router;                             ///< Radix tree of dynamic routes
+    StaticRouteLookup static_routes = nullptr; ///< Perfect-hash table of fixed routes, if installed
+    std::function<Response(RequestInfo&, const RouteMatch&)> pipeline; ///< Flattened middleware chain, if installed
 
     /**
      * @brief The infinite loop executed by each thread in the pool.
@@ -69,8 +159,50 @@ private:
     /**
      * @brief Reads the HTTP request, routes it, and sends the response.
      * @param client_socket The file descriptor for the connected client.
+     * @param resumed A completed deferred response to send before reading the next request.
+     */
+    void handle_client(int client_socket, std::shared_ptr<PendingResponse> resumed = nullptr);
+
+    /**
+     * @brief Sends a response (head, body or stream) and logs it.
+     * @return bool True if the connection stays open for another request.
+     */
+    bool send_response(int client_socket, const RequestInfo& req, Response& res) const;
+
+    /// Queues a connection for the worker pool.
+    void enqueue(ClientTask task);
+
+    /**
+     * @brief Hands a connection with a deferred response to the event loop.
+     * @param buffer Bytes already read past the request.
+     * @param res The handler's response; its defer callback is invoked here.
+     */
+    void park(int client_socket, std::string buffer, const RequestInfo& req, Response res);
+
+    /**
+     * @brief Sends the head of a long-lived response and hands the connection to the event loop,
+     * as a WebSocket (101 handshake) or a Server-Sent Events stream.
+     * @param buffer Bytes already read past the request (e.g., the client's first frames).
+     */
+    void hand_off(int client_socket, std::string buffer, const RequestInfo& req, Response res);
+
+    friend class PendingResponse;
+
+    /**
+     * @brief Looks up the route for a request before its body is read, so the route's
+     * options can decide how the body is received.
+     * @param req The request with its normalized path; path_params receives any captures.
+     * @return RouteMatch The fixed table's match if the path is there, else the router's.
+     */
+    RouteMatch resolve(RequestInfo& req) const;
+
+    /**
+     * @brief Runs the resolved route's handler (the pipeline terminal).
+     * @param req The parsed request.
+     * @param match The result of resolve() for this request.
+     * @return Response The handler's response, a 405, or the static file fallback.
      */
-    void handle_client(int client_socket) const;
+    Response dispatch(RequestInfo& req, const RouteMatch& match) const;
 
     /**
      * @brief Fallback handler for serving static files from the public/ directory.
@@ -0,0 +1,174 @@
+#ifndef STATIC_ROUTES_HPP
+#define STATIC_ROUTES_HPP
+#pragma once
+
+#include "Common.hpp"
+#include "Router.hpp"
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/**
+ * @struct FixedString
+ * @brief A string literal usable as a template argument (C++20 class-type NTTP).
+ */
+template <size_t N>
+struct FixedString {
+    char data[N]{};
+
+    constexpr FixedString(const char (&str)[N]) {
+        for (size_t i = 0; i < N; ++i) data[i] = str[i];
+    }
+
+    [[nodiscard]] constexpr std::string_view view() const { return {data, N - 1}; }
+};
+
+/**
+ * @brief Seeded FNV-1a hash used for both table construction and runtime dispatch.
+ * The final avalanche step makes every seed bit reach the low bits used as the table index.
+ */
+constexpr uint32_t static_route_hash(std::string_view str, uint32_t seed) {
+    uint32_t hash = 2166136261u ^ seed;
+    for (char c : str) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 16777619u;
+    }
+    hash ^= hash >> 16;
+    hash *= 0x85ebca6bu;
+    hash ^= hash >> 13;
+    return hash;
+}
+
+/// MaxBody value of a StaticRoute that keeps the server's default limit (see RouteOptions::max_body).
+inline constexpr size_t DEFAULT_MAX_BODY = SIZE_MAX;
+
+/// Routes for GET and HEAD expect no body, so by default they accept none.
+constexpr size_t default_static_max_body(HttpMethod method) {
+    return (method == HttpMethod::GET || method == HttpMethod::HEAD) ? 0 : DEFAULT_MAX_BODY;
+}
+
+/**
+ * @struct StaticRoute
+ * @brief Declares one compile-time route: a path, a method and a plain function handler.
+ * @tparam Path The URI path, with or without the leading slash. Captures are not supported.
+ * @tparam Method The HTTP method slot.
+ * @tparam Handler A free function; it is called directly, never through std::function.
+ * @tparam MaxBody Largest accepted body in bytes, or DEFAULT_MAX_BODY. Defaults to 0 for GET and HEAD.
+ */
+template <FixedString Path, HttpMethod Method, RawRouteHandler Handler, size_t MaxBody = default_static_max_body(Method)>
+struct StaticRoute {
+    static constexpr std::string_view path =
+        (!Path.view().empty() && Path.view().front() == '/') ? Path.view().substr(1) : Path.view();
+    static constexpr HttpMethod method = Method;
+    static constexpr RawRouteHandler handler = Handler;
+    static constexpr size_t max_body = MaxBody;
+};
+
+/**
+ * @class StaticRouteTable
+ * @brief A route set resolved entirely at compile time into a perfect hash table.
+ *
+ * A seed is searched at compile time so that every distinct path hashes to its own slot of a
+ * power-of-two table. A lookup is therefore one hash, one mask and one string comparison,
+ * and a hit calls the handler through a plain function pointer. Each handler's body limit is
+ * returned with it as RouteOptions, so the server rejects an oversized body before reading it.
+ *
+ * @tparam Routes A list of StaticRoute declarations.
+ */
+template <typename... Routes>
+class StaticRouteTable {
+public:
+    /**
+     * @brief Resolves a path against the fixed route set.
+     * @param method The parsed request method.
+     * @param path The request path, without the leading slash.
+     * @return RouteMatch The direct handler (if any), its options and the methods registered on the path.
+     */
+    static RouteMatch match(HttpMethod method, std::string_view path) {
+        const Slot& slot = TABLE[static_route_hash(path, SEED) & (CAPACITY - 1)];
+        RouteMatch result;
+        if (slot.allowed_methods == 0 || slot.path != path) return result;
+
+        result.allowed_methods = slot.allowed_methods;
+        size_t index = static_cast<size_t>(method);
+        if (!slot.handlers[index] && method == HttpMethod::HEAD) index = static_cast<size_t>(HttpMethod::GET);
+        if (slot.handlers[index]) {
+            result.direct = slot.handlers[index];
+            result.options = &slot.options[index];
+        }
+        return result;
+    }
+
+private:
+    struct Entry {
+        std::string_view path;
+        HttpMethod method;
+        RawRouteHandler handler;
+        size_t max_body;
+    };
+
+    struct Slot {
+        std::string_view path;
+        std::array<RawRouteHandler, HTTP_METHOD_COUNT> handlers{};
+        std::array<RouteOptions, HTTP_METHOD_COUNT> options{};
+        uint16_t allowed_methods = 0;
+    };
+
+    static constexpr size_t COUNT = sizeof...(Routes);
+    static constexpr size_t CAPACITY = std::bit_ceil(COUNT * 2 > 0 ? COUNT * 2 : size_t{1});
+    static constexpr std::array<Entry, COUNT> ENTRIES = {
+        Entry{Routes::path, Routes::method, Routes::handler, Routes::max_body}...};
+
+    static constexpr bool has_duplicates() {
+        for (size_t i = 0; i < COUNT; ++i) {
+            for (size_t j = i + 1; j < COUNT; ++j) {
+                if (ENTRIES[i].path == ENTRIES[j].path && ENTRIES[i].method == ENTRIES[j].method) return true;
+            }
+        }
+        return false;
+    }
+
+    static constexpr uint32_t find_seed() {
+        for (uint32_t seed = 0; seed < (1u << 16); ++seed) {
+            std::array<std::string_view, CAPACITY> owners{};
+            std::array<bool, CAPACITY> taken{};
+            bool collision = false;
+
+            for (const Entry& entry : ENTRIES) {
+                size_t index = static_route_hash(entry.path, seed) & (CAPACITY - 1);
+                if (taken[index] && owners[index] != entry.path) {
+                    collision = true;
+                    break;
+                }
+                taken[index] = true;
+                owners[index] = entry.path;
+            }
+
+            if (!collision) return seed;
+        }
+        return UINT32_MAX;
+    }
+
+    static constexpr std::array<Slot, CAPACITY> build_table() {
+        std::array<Slot, CAPACITY> table{};
+        for (const Entry& entry : ENTRIES) {
+            Slot& slot = table[static_route_hash(entry.path, SEED) & (CAPACITY - 1)];
+            slot.path = entry.path;
+            slot.handlers[static_cast<size_t>(entry.method)] = entry.handler;
+            if (entry.max_body != DEFAULT_MAX_BODY) slot.options[static_cast<size_t>(entry.method)].max_body = entry.max_body;
+            slot.allowed_methods |= static_cast<uint16_t>(1u << static_cast<unsigned>(entry.method));
+        }
+        return table;
+    }
+
+    static_assert(!has_duplicates(), "StaticRouteTable: the same path and method are declared twice");
+
+    static constexpr uint32_t SEED = find_seed();
+    static_assert(SEED != UINT32_MAX, "StaticRouteTable: no collision-free hash seed found");
+
+    static constexpr std::array<Slot, CAPACITY> TABLE = build_table();
+};
+
+#endif // STATIC_ROUTES_HPP
@@ -0,0 +1,201 @@
+#ifndef WEBSOCKET_HPP
+#define WEBSOCKET_HPP
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include "Common.hpp"
+#include "Reactor.hpp"
+#include "FanOut.hpp"
+
+/**
+ * @enum WsOpcode
+ * @brief Frame opcodes defined by RFC 6455, section 5.2.
+ */
+enum class WsOpcode : uint8_t {
+    CONTINUATION = 0x0,
+    TEXT = 0x1,
+    BINARY = 0x2,
+    CLOSE = 0x8,
+    PING = 0x9,
+    PONG = 0xA
+};
+
+/**
+ * @struct WsFrame
+ * @brief One decoded frame, with its payload already unmasked.
+ */
+struct WsFrame {
+    bool fin = true;
+    WsOpcode opcode = WsOpcode::TEXT;
+    std::string payload;
+};
+
+/**
+ * @class WsFrameParser
+ * @brief Incremental decoder for frames sent by a client.
+ *
+ * Bytes are appended to a buffer as they arrive and next() takes complete frames off its front,
+ * so a frame split across reads, or several frames in one read, need no special handling.
+ */
+class WsFrameParser {
+public:
+    enum class Status { NEED_MORE, FRAME, ERROR };
+
+    /// @param max_payload Largest payload accepted in a single frame.
+    explicit WsFrameParser(size_t max_payload) : max_payload(max_payload) {}
+
+    /**
+     * @brief Decodes the next frame from the front of the buffer.
+     * @param buffer Received bytes; a decoded frame is erased from it.
+     * @param frame Receives the frame when FRAME is returned.
+     * @return Status ERROR for protocol violations (unmasked frame, reserved bits, oversized or
+     *         fragmented control frame, payload over the limit); the connection must be closed.
+     */
+    Status next(std::string& buffer, WsFrame& frame) const;
+
+private:
+    size_t max_payload;
+};
+
+/**
+ * @brief Encodes a server frame (unmasked, FIN set).
+ * @param opcode The frame type.
+ * @param payload The payload; control frames must keep it within 125 bytes.
+ * @return std::string The frame, ready to be written to the socket.
+ */
+std::string ws_encode_frame(WsOpcode opcode, std::string_view payload);
+
+/**
+ * @brief Computes the Sec-WebSocket-Accept value for a handshake.
+ * @param client_key The Sec-WebSocket-Key header sent by the client.
+ * @return std::string base64(SHA-1(key + RFC 6455 GUID)).
+ */
+std::string ws_accept_key(std::string_view client_key);
+
+class WebSocket;
+
+/// Called on the event loop with a freshly upgraded connection, to install its callbacks.
+using WebSocketOpen = std::function<void(const std::shared_ptr<WebSocket>&)>;
+
+/**
+ * @brief Answers a WebSocket handshake.
+ *
+ * Validates the upgrade request (GET, Upgrade: websocket, Connection: Upgrade, version 13, a key)
+ * and returns the 101 response that switches the connection over, or an error response if the
+ * request is not a valid handshake.
+ * @param req The HTTP request.
+ * @param on_open Installs the connection's callbacks once the handshake has been sent.
+ */
+Response websocket_upgrade(const RequestInfo& req, WebSocketOpen on_open);
+
+/**
+ * @class WebSocket
+ * @brief A server-side WebSocket connection served by the event loop.
+ *
+ * After the handshake the socket leaves the worker pool for good: the reactor reads and decodes
+ * its frames, answers pings, sends keepalive pings of its own and closes it if the peer stops
+ * answering. Outgoing frames are queued and written as the socket accepts them, so a slow reader
+ * costs buffered bytes rather than a blocked thread; past max_buffered the connection is closed.
+ * Broadcasts arrive through follow(), which bounds them per connection instead.
+ *
+ * Callbacks run on the loop thread and must not block. send_text(), send() and close() may be
+ * called from any thread.
+ */
+class WebSocket : public std::enable_shared_from_this<WebSocket> {
+public:
+    using MessageHandler = std::function<void(WebSocket& socket, std::string_view text)>;
+    using CloseHandler = std::function<void(WebSocket& socket)>;
+
+    struct Options {
+        size_t max_message = 64 * 1024;                  ///< Largest incoming message, after reassembly.
+        size_t max_buffered = 1024 * 1024;               ///< Unsent bytes allowed before the peer counts as dead.
+        std::chrono::seconds ping_interval{30};          ///< Idle time before a ping; a second silent interval closes.
+    };
+
+    WebSocket(Reactor& reactor, int socket, std::string received, Options options);
+    ~WebSocket();
+
+    WebSocket(const WebSocket&) = delete;
+    WebSocket& operator=(const WebSocket&) = delete;
+
+    /// Sets the handler for complete text and binary messages (loop thread only).
+    void on_message(MessageHandler handler) { message_handler = std::move(handler); }
+
+    /// Sets the handler called once when the connection ends, for any reason (loop thread only).
+    void on_close(CloseHandler handler) { close_handler = std::move(handler); }
+
+    /// Queues a text message.
+    void send_text(std::string_view text);
+
+    /**
+     * @brief Queues an already encoded frame (see ws_encode_frame).
+     *
+     * The frame is shared, not copied, so one encoding can be sent to many connections.
+     */
+    void send(std::shared_ptr<const std::string> frame);
+
+    /// Starts the closing handshake with a status code (1000 = normal closure).
+    void close(uint16_t code = 1000);
+
+    /**
+     * @brief Subscribes the connection to a broadcast (loop thread only, e.g., from the open callback).
+     *
+     * Frames are taken from the subscriber's ring only as fast as the socket accepts them, so a
+     * slow reader is handled by the fan-out's policy instead of growing this connection's buffer.
+     * The subscription ends with the connection; the FanOut must outlive it.
+     */
+    void follow(FanOut& feed);
+
+    /// False once the connection is closing or closed.
+    [[nodiscard]] bool is_open() const { return open.load(std::memory_order_acquire); }
+
+private:
+    friend class HttpServer;
+
+    Reactor& reactor;
+    int socket;
+    Options options;
+    WsFrameParser parser;
+    std::string input;                               ///< Received bytes not decoded yet.
+    std::string message;                             ///< Fragments of the message being reassembled.
+    bool fragmented = false;
+    WsOpcode message_opcode = WsOpcode::TEXT;
+
+    std::deque<std::shared_ptr<const std::string>> outbox;
+    size_t outbox_offset = 0;                        ///< Bytes of outbox.front() already written.
+    size_t buffered = 0;                             ///< Unsent bytes in the outbox.
+    bool writing = false;                            ///< EPOLLOUT is being watched.
+
+    std::atomic<bool> open{true};
+    bool closed = false;                             ///< Socket released (loop thread).
+    bool close_sent = false;
+    bool heard_from_peer = true;                     ///< Anything received since the last keepalive check.
+    uint64_t ping_timer = 0;
+
+    MessageHandler message_handler;
+    CloseHandler close_handler;
+
+    FanOut* feed_source = nullptr;
+    std::shared_ptr<FanOutSubscriber> feed;          ///< Broadcast frames waiting for this connection.
+
+    void start(const WebSocketOpen& on_open);
+    void handle_events(uint32_t events);
+    bool read_input();
+    bool handle_frame(WsFrame& frame);
+    void queue(std::shared_ptr<const std::string> frame);
+    bool flush();
+    bool refill();
+    void pump();
+    void send_close(uint16_t code);
+    void schedule_ping();
+    void shutdown();
+};
+
+#endif // WEBSOCKET_HPP
@@ -0,0 +1,114 @@
+#ifndef WRITE_QUEUE_HPP
+#define WRITE_QUEUE_HPP
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Common.hpp"
+
+class PipelinePool;
+
+/**
+ * @enum Durability
+ * @brief When WriteBehindQueue::submit() reports success.
+ */
+enum class Durability : uint8_t {
+    ENQUEUE,    ///< As soon as the message is queued; a crash can lose the last few milliseconds of writes.
+    COMMIT      ///< Once the batch holding the message has committed.
+};
+
+/**
+ * @class WriteBehindQueue
+ * @brief Group commit for chat messages.
+ *
+ * Workers hand messages to submit() instead of opening a transaction each. A background thread
+ * collects whatever arrives within flush_interval (or until max_batch messages are pending) and
+ * writes the lot with one multi-row INSERT. The INSERT is sent alone over a pipelined connection
+ * and commits on its own, so a burst of posts costs one round trip, one commit and one WAL flush
+ * instead of one each per message. With Durability::COMMIT a worker still waits for its batch,
+ * but shares that wait with every other message in it.
+ */
+class WriteBehindQueue {
+public:
+    struct Options {
+        Durability durability = Durability::COMMIT;
+        std::chrono::milliseconds flush_interval{5};     ///< Longest a message waits for company.
+        size_t max_batch = 512;                          ///< Messages per INSERT; a full batch is written at once.
+        size_t max_pending = 10000;                      ///< Messages queued before submit() refuses more.
+
+        /// Called on the writer thread with each committed batch (ids and timestamps filled in),
+        /// before the submitters waiting on it are released.
+        std::function<void(std::vector<Message>)> on_commit;
+    };
+
+    /// Name of the batch INSERT in the pool's statement registry.
+    static constexpr const char* INSERT_BATCH = "chat_insert_batch";
+
+    /**
+     * @brief Registers the batch INSERT with the pool and starts the writer thread.
+     * @param pool The pipelined connections the writer borrows; must outlive the queue.
+     * @param options Batching and durability settings.
+     */
+    WriteBehindQueue(PipelinePool& pool, Options options);
+
+    /// Writes everything still queued, then stops the writer thread.
+    ~WriteBehindQueue();
+
+    WriteBehindQueue(const WriteBehindQueue&) = delete;
+    WriteBehindQueue& operator=(const WriteBehindQueue&) = delete;
+
+    /**
+     * @brief Queues a message for insertion.
+     * @return bool False if the queue is full or shutting down, or, with Durability::COMMIT,
+     * if its batch failed to commit.
+     */
+    bool submit(Message message);
+
+    /// Blocks until everything queued so far has been written (or has failed).
+    void flush();
+
+    /**
+     * @brief Renders the queue counters in the Prometheus text exposition format.
+     * @return std::string One "name value" line per metric.
+     */
+    [[nodiscard]] std::string to_prometheus() const;
+
+private:
+    // Completion state shared by every message of one batch
+    struct Batch {
+        std::vector<Message> messages;
+        bool done = false;
+        bool ok = false;
+    };
+
+    PipelinePool& pool;
+    Options options;
+
+    mutable std::mutex mutex;
+    std::condition_variable has_work;                ///< Signalled to the writer thread.
+    std::condition_variable batch_done;              ///< Signalled to submitters waiting on a commit.
+    std::shared_ptr<Batch> open;                     ///< Collecting messages; swapped out by the writer.
+    std::chrono::steady_clock::time_point open_since;
+    bool writing = false;
+    bool stopping = false;
+    std::thread writer;
+
+    std::atomic<uint64_t> submitted{0};
+    std::atomic<uint64_t> rejected{0};
+    std::atomic<uint64_t> written{0};
+    std::atomic<uint64_t> failed{0};
+    std::atomic<uint64_t> batches{0};
+
+    void run();
+    bool write(const std::vector<Message>& messages);
+};
+
+#endif // WRITE_QUEUE_HPP
@@ -0,0 +1,150 @@
+// Huji-Chat dashboard: the server renders the latest messages; older ones are fetched from
+// /api/messages page by page as the chat box is scrolled to the top. New messages arrive over
+// the /ws/chat WebSocket, and the form posts in the background instead of reloading the page.
+(function () {
+    const PAGE_SIZE = 50;
+    const box = document.getElementById('chat-box');
+    if (!box) return;
+
+    let loading = false;
+    let exhausted = false;
+
+    function oldestId() {
+        const first = box.querySelector('.msg[data-id]');
+        return first ? first.dataset.id : null;
+    }
+
+    function newestId() {
+        const all = box.querySelectorAll('.msg[data-id]');
+        return all.length ? Number(all[all.length - 1].dataset.id) : 0;
+    }
+
+    // Built with textContent so message text is never interpreted as HTML
+    function renderMessage(message) {
+        const msg = document.createElement('div');
+        msg.className = 'msg';
+        msg.dataset.id = message.id;
+
+        const header = document.createElement('div');
+        header.className = 'msg-header';
+        const user = document.createElement('span');
+        user.className = 'msg-user';
+        user.textContent = message.user;
+        const time = document.createElement('span');
+        time.className = 'msg-time';
+        time.textContent = message.time;
+        header.append(user, time);
+
+        const text = document.createElement('div');
+        text.className = 'msg-text';
+        text.textContent = message.text;
+
+        msg.append(header, text);
+        return msg;
+    }
+
+    async function loadOlder() {
+        const before = oldestId();
+        if (loading || exhausted || before === null) return;
+        loading = true;
+        try {
+            const response = await fetch('/api/messages?before=' + before + '&limit=' + PAGE_SIZE);
+            if (!response.ok) return;
+            const page = await response.json();
+
+            const fragment = document.createDocumentFragment();
+            page.messages.forEach(message => fragment.appendChild(renderMessage(message)));
+
+            // Keep the message the reader is looking at in place while content grows above it
+            const previousHeight = box.scrollHeight;
+            box.insertBefore(fragment, box.querySelector('.msg[data-id]'));
+            box.scrollTop += box.scrollHeight - previousHeight;
+
+            exhausted = !page.has_more;
+        } catch (error) {
+            console.error('Could not load older messages', error);
+        } finally {
+            loading = false;
+        }
+    }
+
+    // Adds messages in id order, skipping ones already shown; follows along if the reader is at the bottom
+    function addMessages(messages) {
+        const atBottom = box.scrollHeight - box.scrollTop - box.clientHeight < 50;
+        messages.forEach(message => {
+            if (message.id > newestId()) {
+                box.appendChild(renderMessage(message));
+                return;
+            }
+            // A catch-up page can land behind messages pushed meanwhile
+            if (box.querySelector('.msg[data-id="' + message.id + '"]')) return;
+            const later = Array.from(box.querySelectorAll('.msg[data-id]')).find(node => Number(node.dataset.id) > message.id);
+            if (later) box.insertBefore(renderMessage(message), later);
+        });
+        if (atBottom) box.scrollTop = box.scrollHeight;
+    }
+
+    // Fills the gap left while the socket was down or the server skipped messages for us
+    async function catchUp(after) {
+        for (;;) {
+            const response = await fetch('/api/messages?after=' + after + '&limit=' + PAGE_SIZE);
+            if (!response.ok) return;
+            const page = await response.json();
+            addMessages(page.messages);
+            if (!page.has_more || page.messages.length === 0) return;
+            after = page.messages[page.messages.length - 1].id;
+        }
+    }
+
+    let retryDelay = 1000;
+    function connect() {
+        const scheme = location.protocol === 'https:' ? 'wss://' : 'ws://';
+        const socket = new WebSocket(scheme + location.host + '/ws/chat');
+        let lastSeen = newestId(); // Pushes arrive in order; a gap starts after the last one received
+        const resync = () => catchUp(lastSeen).catch(error => console.error('Could not catch up', error));
+        socket.onopen = () => {
+            retryDelay = 1000;
+            resync();
+        };
+        socket.onmessage = event => {
+            const message = JSON.parse(event.data);
+            // Sent instead of the messages we were too slow to receive
+            if (message.resync) {
+                resync();
+                return;
+            }
+            lastSeen = message.id;
+            addMessages([message]);
+        };
+        socket.onclose = () => {
+            setTimeout(connect, retryDelay);
+            retryDelay = Math.min(retryDelay * 2, 30000);
+        };
+    }
+
+    const form = document.querySelector('.chat-form');
+    if (form && 'WebSocket' in window) {
+        form.addEventListener('submit', async event => {
+            event.preventDefault();
+            const textarea = form.querySelector('textarea[name="message"]');
+            try {
+                const response = await fetch('/chat', {
+                    method: 'POST',
+                    headers: {'Accept': 'application/json'},
+                    body: new URLSearchParams(new FormData(form))
+                });
+                if (response.ok) textarea.value = '';
+            } catch (error) {
+                console.error('Could not send the message', error);
+            }
+        });
+        connect();
+    }
+
+    box.addEventListener('scroll', () => {
+        if (box.scrollTop < 100) loadOlder();
+    });
+
+    // Start at the newest message
+    box.scrollTop = box.scrollHeight;
+})();
@@ -0,0 +1,246 @@
+#include "../include/BodyStream.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+
+// ==========================================
+// CHUNKED DECODER
+// ==========================================
+
+namespace {
+    int hex_value(char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
+}
+
+ChunkedDecoder::Status ChunkedDecoder::decode(std::string_view input, size_t& consumed, std::string_view& data) {
+    size_t pos = 0;
+
+    while (pos < input.size()) {
+        char c = input[pos];
+
+        switch (state) {
+            case State::SIZE: {
+                int digit = hex_value(c);
+                if (digit >= 0) {
+                    // 15 hex digits is far beyond any acceptable body and cannot overflow
+                    if (++size_digits > 15) goto fail;
+                    chunk_left = chunk_left * 16 + static_cast<uint64_t>(digit);
+                    ++pos;
+                    break;
+                }
+                if (size_digits == 0) goto fail;
+                line_bytes = size_digits;
+                state = State::EXTENSION;
+                break;
+            }
+
+            case State::EXTENSION:
+                // Whitespace and ";name=value" extensions are ignored up to the line break
+                ++pos;
+                if (c == '\r') {
+                    state = State::SIZE_LF;
+                } else if (c == '\n' || ++line_bytes > MAX_LINE_BYTES) {
+                    goto fail;
+                }
+                break;
+
+            case State::SIZE_LF:
+                if (c != '\n') goto fail;
+                ++pos;
+                line_bytes = 0;
+                state = chunk_left == 0 ? State::TRAILER : State::DATA;
+                break;
+
+            case State::DATA: {
+                size_t take = static_cast<size_t>(std::min<uint64_t>(chunk_left, input.size() - pos));
+                data = input.substr(pos, take);
+                chunk_left -= take;
+                if (chunk_left == 0) state = State::DATA_CR;
+                consumed = pos + take;
+                return Status::DATA;
+            }
+
+            case State::DATA_CR:
+                if (c != '\r') goto fail;
+                ++pos;
+                state = State::DATA_LF;
+                break;
+
+            case State::DATA_LF:
+                if (c != '\n') goto fail;
+                ++pos;
+                size_digits = 0;
+                state = State::SIZE;
+                break;
+
+            case State::TRAILER:
+                // Trailer fields end with an empty line; their contents are not used
+                ++pos;
+                if (c == '\r') {
+                    state = State::TRAILER_LF;
+                } else if (c == '\n' || ++line_bytes > MAX_LINE_BYTES) {
+                    goto fail;
+                }
+                break;
+
+            case State::TRAILER_LF:
+                if (c != '\n') goto fail;
+                ++pos;
+                if (line_bytes == 0) {
+                    state = State::DONE;
+                    consumed = pos;
+                    return Status::DONE;
+                }
+                line_bytes = 0;
+                state = State::TRAILER;
+                break;
+
+            case State::DONE:
+                consumed = pos;
+                return Status::DONE;
+
+            case State::ERROR:
+                goto fail;
+        }
+    }
+
+    consumed = pos;
+    return state == State::DONE ? Status::DONE : Status::NEED_MORE;
+
+fail:
+    state = State::ERROR;
+    consumed = pos;
+    return Status::ERROR;
+}
+
+// ==========================================
+// BODY STREAM
+// ==========================================
+
+BodyStream::BodyStream(int socket, std::string& pending, size_t content_length)
+    : socket(socket), pending(pending), remaining(content_length), complete(content_length == 0) {}
+
+BodyStream::BodyStream(int socket, std::string& pending, Chunked, size_t limit)
+    : socket(socket), pending(pending), is_chunked(true), limit(limit) {}
+
+BodyStream::~BodyStream() {
+    // Leave only what follows this body in the connection buffer
+    pending.erase(0, pending_pos);
+}
+
+std::string_view BodyStream::next() {
+    if (!partial.empty()) {
+        std::string_view rest = partial;
+        partial = {};
+        return rest;
+    }
+    if (complete || error) return {};
+
+    std::string_view result = is_chunked ? next_chunked() : next_fixed();
+    total += result.size();
+    return result;
+}
+
+std::string_view BodyStream::next_fixed() {
+    // Bytes that arrived together with the headers come first
+    if (pending_pos < pending.size()) {
+        size_t take = std::min(pending.size() - pending_pos, remaining);
+        std::string_view head(pending.data() + pending_pos, take);
+        pending_pos += take;
+        remaining -= take;
+        complete = remaining == 0;
+        return head;
+    }
+
+    // Never read past the body, so a pipelined request stays in the socket
+    ssize_t got;
+    do {
+        got = ::read(socket, slice.data(), std::min(slice.size(), remaining));
+    } while (got < 0 && errno == EINTR);
+
+    if (got <= 0) {
+        error = true;
+        return {};
+    }
+    remaining -= static_cast<size_t>(got);
+    complete = remaining == 0;
+    return {slice.data(), static_cast<size_t>(got)};
+}
+
+std::string_view BodyStream::next_chunked() {
+    while (true) {
+        size_t consumed = 0;
+        std::string_view data;
+        ChunkedDecoder::Status status =
+            decoder.decode(std::string_view(pending).substr(pending_pos), consumed, data);
+        pending_pos += consumed;
+
+        switch (status) {
+            case ChunkedDecoder::Status::DATA:
+                if (total + data.size() > limit) {
+                    error = over_limit = true;
+                    return {};
+                }
+                return data;
+
+            case ChunkedDecoder::Status::DONE:
+                complete = true;
+                return {};
+
+            case ChunkedDecoder::Status::ERROR:
+                error = true;
+                return {};
+
+            case ChunkedDecoder::Status::NEED_MORE:
+                break;
+        }
+
+        // The previous slice is no longer referenced, so the buffer can be compacted before refilling
+        pending.erase(0, pending_pos);
+        pending_pos = 0;
+
+        ssize_t got;
+        do {
+            got = ::read(socket, slice.data(), slice.size());
+        } while (got < 0 && errno == EINTR);
+
+        if (got <= 0) {
+            error = true;
+            return {};
+        }
+        pending.append(slice.data(), static_cast<size_t>(got));
+    }
+}
+
+size_t BodyStream::read(char* dst, size_t size) {
+    if (partial.empty()) partial = next();
+    size_t count = std::min(size, partial.size());
+    std::memcpy(dst, partial.data(), count);
+    partial.remove_prefix(count);
+    return count;
+}
+
+bool BodyStream::read_all(std::string& out) {
+    if (!is_chunked) out.reserve(out.size() + partial.size() + remaining);
+    for (std::string_view chunk = next(); !chunk.empty(); chunk = next()) {
+        out.append(chunk);
+    }
+    return finished() && !error;
+}
+
+bool BodyStream::discard(size_t max_bytes) {
+    partial = {};
+    if (!is_chunked && remaining > max_bytes) return false;
+
+    size_t drained = 0;
+    for (std::string_view chunk = next(); !chunk.empty(); chunk = next()) {
+        drained += chunk.size();
+        if (drained > max_bytes) return false;
+    }
+    return finished() && !error;
+}
@@ -1,5 +1,168 @@
 #include "../include/Common.hpp"
+#include <algorithm>
 #include <sstream>
+#include <stdexcept>
+#include <strings.h>
+#include <unistd.h>
+
+UploadedFile::UploadedFile(UploadedFile&& other) noexcept
+	: field(std::move(other.field)), filename(std::move(other.filename)),
+	  content_type(std::move(other.content_type)), temp_path(std::move(other.temp_path)), size(other.size) {
+	other.temp_path.clear();
+}
+
+UploadedFile& UploadedFile::operator=(UploadedFile&& other) noexcept {
+	if (this != &other) {
+		if (!temp_path.empty()) unlink(temp_path.c_str());
+		field = std::move(other.field);
+		filename = std::move(other.filename);
+		content_type = std::move(other.content_type);
+		temp_path = std::move(other.temp_path);
+		size = other.size;
+		other.temp_path.clear();
+	}
+	return *this;
+}
+
+UploadedFile::~UploadedFile() {
+	// Spilled uploads are scratch data unless a handler claimed them
+	if (!temp_path.empty()) unlink(temp_path.c_str());
+}
+
+ParamStore::value_type ParamStore::entry_at(size_t index) const {
+	const Entry& e = entry_ref(index);
+	return {std::string_view(arena).substr(e.key_off, e.key_len),
+	        std::string_view(arena).substr(e.val_off, e.val_len)};
+}
+
+size_t ParamStore::find_index(std::string_view key) const {
+	std::string_view data(arena);
+	if (slots.empty()) {
+		for (size_t i = 0; i < count; ++i) {
+			const Entry& e = entry_ref(i);
+			if (e.key_len == key.size() && data.substr(e.key_off, e.key_len) == key) return i;
+		}
+		return count;
+	}
+
+	// Linear probing; the table is kept at most half full, so an empty slot always ends the search
+	size_t mask = slots.size() - 1;
+	for (size_t slot = std::hash<std::string_view>{}(key) & mask; slots[slot] != 0; slot = (slot + 1) & mask) {
+		const Entry& e = entry_ref(slots[slot] - 1);
+		if (e.key_len == key.size() && data.substr(e.key_off, e.key_len) == key) return slots[slot] - 1;
+	}
+	return count;
+}
+
+void ParamStore::hash_entry(size_t index) {
+	const Entry& e = entry_ref(index);
+	size_t mask = slots.size() - 1;
+	size_t slot = std::hash<std::string_view>{}(std::string_view(arena).substr(e.key_off, e.key_len)) & mask;
+	while (slots[slot] != 0) slot = (slot + 1) & mask;
+	slots[slot] = static_cast<uint32_t>(index + 1);
+}
+
+void ParamStore::rehash(size_t capacity) {
+	slots.assign(capacity, 0);
+	for (size_t i = 0; i < count; ++i) hash_entry(i);
+}
+
+const ParamStore::Entry* ParamStore::find(std::string_view key) const {
+	size_t index = find_index(key);
+	return index < count ? &entry_ref(index) : nullptr;
+}
+
+std::string_view ParamStore::at(std::string_view key) const {
+	const Entry* e = find(key);
+	if (!e) throw std::out_of_range("ParamStore::at: no parameter named '" + std::string(key) + "'");
+	return std::string_view(arena).substr(e->val_off, e->val_len);
+}
+
+std::string_view ParamStore::get(std::string_view key, std::string_view fallback) const {
+	const Entry* e = find(key);
+	return e ? std::string_view(arena).substr(e->val_off, e->val_len) : fallback;
+}
+
+void ParamStore::set(std::string_view key, std::string_view value) {
+	size_t key_off = arena.size();
+	arena.append(key);
+	arena.append(value);
+	index_entry(key_off, key.size(), key_off + key.size(), value.size());
+}
+
+void ParamStore::index_entry(size_t key_off, size_t key_len, size_t val_off, size_t val_len) {
+	Entry entry{static_cast<uint32_t>(key_off), static_cast<uint32_t>(key_len),
+	            static_cast<uint32_t>(val_off), static_cast<uint32_t>(val_len)};
+
+	// Repeated keys keep their slot and point at the newest value
+	size_t existing = find_index(std::string_view(arena).substr(key_off, key_len));
+	if (existing < count) {
+		entry_ref(existing).val_off = entry.val_off;
+		entry_ref(existing).val_len = entry.val_len;
+		return;
+	}
+
+	if (count < INLINE_CAPACITY) {
+		inline_entries[count] = entry;
+	} else {
+		overflow.push_back(entry);
+	}
+	++count;
+
+	// Small stores keep the linear scan; larger ones are hashed, doubling the table to stay half empty
+	if (count <= INLINE_CAPACITY) return;
+	if (count * 2 > slots.size()) {
+		rehash(std::max(slots.size() * 2, INLINE_CAPACITY * 8));
+	} else {
+		hash_entry(count - 1);
+	}
+}
+
+std::string_view RequestInfo::path_param(std::string_view name) const {
+	for (const auto& [key, val] : path_params) {
+		if (key == name) return val;
+	}
+	return {};
+}
+
+std::string_view RequestInfo::header(std::string_view name) const {
+	std::string_view rest(head);
+
+	// Skip the request line, then compare each "Name:" prefix
+	size_t eol = rest.find("\r\n");
+	while (eol != std::string_view::npos) {
+		rest.remove_prefix(eol + 2);
+		eol = rest.find("\r\n");
+		std::string_view line = rest.substr(0, eol);
+
+		if (line.size() > name.size() && line[name.size()] == ':' &&
+		    strncasecmp(line.data(), name.data(), name.size()) == 0) {
+			std::string_view value = line.substr(name.size() + 1);
+			while (!value.empty() && (value.front() == ' ' || value.front() == '\t')) value.remove_prefix(1);
+			while (!value.empty() && (value.back() == ' ' || value.back() == '\t')) value.remove_suffix(1);
+			return value;
+		}
+	}
+	return {};
+}
+
+size_t RequestInfo::header_count(std::string_view name) const {
+	std::string_view rest(head);
+	size_t count = 0;
+
+	size_t eol = rest.find("\r\n");
+	while (eol != std::string_view::npos) {
+		rest.remove_prefix(eol + 2);
+		eol = rest.find("\r\n");
+		std::string_view line = rest.substr(0, eol);
+
+		if (line.size() > name.size() && line[name.size()] == ':' &&
+		    strncasecmp(line.data(), name.data(), name.size()) == 0) {
+			++count;
+		}
+	}
+	return count;
+}
 
 std::string Response::to_string() const {
 	std::ostringstream oss;
@@ -7,18 +170,25 @@ std::string Response::to_string() const {
 	// Build the HTTP status line
 	oss << "HTTP/1.1 " << status_code << " " << status_text << "\r\n";
 
-	// Build standard headers
-	oss << "Content-Type: " << content_type << "\r\n";
-	oss << "Content-Length: " << body.length() << "\r\n";
-	oss << "Connection: " << (keep_alive ? "keep-alive" : "close") << "\r\n";
+	// Build standard headers; a protocol switch has no body and brings its own Connection header
+	if (status_code != 101) {
+		oss << "Content-Type: " << content_type << "\r\n";
+		if (stream || event_stream) {
+			oss << "Transfer-Encoding: chunked\r\n";
+		} else {
+			oss << "Content-Length: " << body.length() << "\r\n";
+		}
+		oss << "Connection: " << (keep_alive ? "keep-alive" : "close") << "\r\n";
+	}
 
 	// Append custom headers
 	for (const auto& [key, val] : headers) {
 		oss << key << ": " << val << "\r\n";
 	}
 
-	// Append the body separated by a blank line
-	oss << "\r\n" << body;
+	// Append the body separated by a blank line (a stream sends its own)
+	oss << "\r\n";
+	if (!stream && !event_stream) oss << body;
 
 	return oss.str();
 }
\ No newline at end of file
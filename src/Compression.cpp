@@ -0,0 +1,185 @@
+#include "../include/Compression.hpp"
+#include "../include/ResponseWriter.hpp"
+#include <array>
+#include <charconv>
+#include <memory>
+#include <strings.h>
+
+namespace {
+    bool iequals(std::string_view a, std::string_view b) {
+        return a.size() == b.size() && strncasecmp(a.data(), b.data(), a.size()) == 0;
+    }
+
+    bool istarts_with(std::string_view text, std::string_view prefix) {
+        return text.size() >= prefix.size() && strncasecmp(text.data(), prefix.data(), prefix.size()) == 0;
+    }
+
+    bool iends_with(std::string_view text, std::string_view suffix) {
+        return text.size() >= suffix.size() &&
+               strncasecmp(text.data() + text.size() - suffix.size(), suffix.data(), suffix.size()) == 0;
+    }
+
+    std::string_view trim(std::string_view text) {
+        while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) text.remove_prefix(1);
+        while (!text.empty() && (text.back() == ' ' || text.back() == '\t')) text.remove_suffix(1);
+        return text;
+    }
+
+    // Quality value of one Accept-Encoding element ("gzip;q=0.5" -> 0.5, "gzip" -> 1)
+    double parse_quality(std::string_view params) {
+        size_t q = params.find("q=");
+        if (q == std::string_view::npos) return 1.0;
+        std::string_view value = trim(params.substr(q + 2));
+        double quality = 1.0;
+        auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), quality);
+        return ec == std::errc() ? quality : 1.0;
+    }
+}
+
+ContentCoding negotiate_encoding(std::string_view accept_encoding) {
+    double gzip = -1.0;
+    double deflate = -1.0;
+    double wildcard = -1.0;
+
+    while (!accept_encoding.empty()) {
+        size_t comma = accept_encoding.find(',');
+        std::string_view element = accept_encoding.substr(0, comma);
+        accept_encoding = comma == std::string_view::npos ? std::string_view{} : accept_encoding.substr(comma + 1);
+
+        size_t semicolon = element.find(';');
+        std::string_view name = trim(element.substr(0, semicolon));
+        double quality = semicolon == std::string_view::npos ? 1.0 : parse_quality(element.substr(semicolon + 1));
+
+        if (iequals(name, "gzip") || iequals(name, "x-gzip")) {
+            gzip = quality;
+        } else if (iequals(name, "deflate")) {
+            deflate = quality;
+        } else if (name == "*") {
+            wildcard = quality;
+        }
+    }
+
+    // Codings not listed explicitly inherit the wildcard's quality
+    if (gzip < 0) gzip = wildcard;
+    if (deflate < 0) deflate = wildcard;
+
+    if (gzip > 0 && gzip >= deflate) return ContentCoding::GZIP;
+    if (deflate > 0) return ContentCoding::DEFLATE;
+    return ContentCoding::IDENTITY;
+}
+
+std::string_view content_coding_name(ContentCoding coding) {
+    switch (coding) {
+        case ContentCoding::GZIP: return "gzip";
+        case ContentCoding::DEFLATE: return "deflate";
+        case ContentCoding::IDENTITY: break;
+    }
+    return {};
+}
+
+bool is_compressible(std::string_view content_type) {
+    std::string_view type = trim(content_type.substr(0, content_type.find(';')));
+    if (istarts_with(type, "text/")) return true;
+    if (iends_with(type, "+json") || iends_with(type, "+xml")) return true;
+    return iequals(type, "application/json") || iequals(type, "application/javascript") ||
+           iequals(type, "application/xml") || iequals(type, "image/svg+xml");
+}
+
+// ==========================================
+// DEFLATER
+// ==========================================
+
+Deflater::Deflater(ContentCoding coding) : coding(coding) {
+    // windowBits 15 selects the zlib wrapper; adding 16 selects the gzip wrapper instead
+    int window_bits = coding == ContentCoding::GZIP ? 15 + 16 : 15;
+    ready = deflateInit2(&stream, LEVEL, Z_DEFLATED, window_bits, 8, Z_DEFAULT_STRATEGY) == Z_OK;
+}
+
+Deflater::~Deflater() {
+    if (ready) deflateEnd(&stream);
+}
+
+bool Deflater::compress(std::string_view input, std::string& out, int flush) {
+    if (!ready) return false;
+
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+    stream.avail_in = static_cast<uInt>(input.size());
+
+    while (true) {
+        // deflateBound covers the pending output too, so a finishing call normally needs one round
+        size_t room = deflateBound(&stream, stream.avail_in) + 64;
+        size_t old_size = out.size();
+        out.resize(old_size + room);
+        stream.next_out = reinterpret_cast<Bytef*>(out.data() + old_size);
+        stream.avail_out = static_cast<uInt>(room);
+
+        int status = deflate(&stream, flush);
+        out.resize(old_size + room - stream.avail_out);
+
+        if (status == Z_STREAM_ERROR) return false;
+        if (flush == Z_FINISH ? status == Z_STREAM_END : stream.avail_out != 0) return true;
+    }
+}
+
+Deflater* Deflater::acquire(ContentCoding coding) {
+    thread_local std::array<std::unique_ptr<Deflater>, 3> cache;
+
+    std::unique_ptr<Deflater>& slot = cache[static_cast<size_t>(coding)];
+    if (!slot) {
+        slot = std::make_unique<Deflater>(coding);
+        slot->cached = true;
+    }
+
+    Deflater* deflater = slot.get();
+    if (deflater->busy) deflater = new Deflater(coding);
+    deflater->busy = true;
+    return deflater;
+}
+
+void Deflater::release(Deflater* deflater) {
+    if (!deflater) return;
+    if (!deflater->cached) {
+        delete deflater;
+        return;
+    }
+    // An aborted stream may be mid-way; start the next response from a clean state
+    if (deflater->ready) deflateReset(&deflater->stream);
+    deflater->busy = false;
+}
+
+// ==========================================
+// RESPONSE COMPRESSION
+// ==========================================
+
+void compress_response(const RequestInfo& req, Response& res, size_t min_size) {
+    if (res.status_code < 200 || res.status_code == 204 || res.status_code == 304) return;
+    if (res.headers.count("Content-Encoding") || !is_compressible(res.content_type)) return;
+
+    // The representation now depends on the request, which shared caches must know
+    res.headers["Vary"] = "Accept-Encoding";
+
+    ContentCoding coding = negotiate_encoding(req.header("Accept-Encoding"));
+    if (coding == ContentCoding::IDENTITY) return;
+
+    if (res.stream) {
+        res.stream = [inner = std::move(res.stream), coding](ResponseWriter& out) {
+            out.set_compression(coding);
+            inner(out);
+        };
+        res.headers["Content-Encoding"] = std::string(content_coding_name(coding));
+        return;
+    }
+
+    if (res.body.size() < min_size) return;
+
+    Deflater* deflater = Deflater::acquire(coding);
+    std::string compressed;
+    bool ok = deflater->compress(res.body, compressed, Z_FINISH);
+    Deflater::release(deflater);
+
+    // Already-dense payloads can grow slightly; keep the original then
+    if (!ok || compressed.size() >= res.body.size()) return;
+
+    res.body.swap(compressed);
+    res.headers["Content-Encoding"] = std::string(content_coding_name(coding));
+}
@@ -0,0 +1,215 @@
+#include "../include/Database.hpp"
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+using Clock = std::chrono::steady_clock;
+
+// ==========================================
+// STATEMENT REGISTRY
+// ==========================================
+
+void StatementRegistry::add(std::string name, std::string sql) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const PreparedStatement& existing : statements) {
+        if (existing.name != name) continue;
+        if (existing.sql == sql) return;
+        throw std::invalid_argument("Prepared statement '" + name + "' is already registered with different SQL");
+    }
+    statements.push_back({std::move(name), std::move(sql)});
+}
+
+size_t StatementRegistry::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return statements.size();
+}
+
+std::vector<PreparedStatement> StatementRegistry::since(size_t from) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (from >= statements.size()) return {};
+    return {statements.begin() + static_cast<std::ptrdiff_t>(from), statements.end()};
+}
+
+size_t StatementRegistry::prepare_on(pqxx::connection& conn, size_t from) const {
+    // Copy the missing entries so the lock is not held across round trips to the server
+    std::vector<PreparedStatement> pending = since(from);
+    for (const PreparedStatement& statement : pending) {
+        conn.prepare(statement.name, statement.sql);
+    }
+    return from + pending.size();
+}
+
+// ==========================================
+// LEASE
+// ==========================================
+
+ConnectionPool::Lease::~Lease() {
+    if (pool) pool->give_back(std::move(slot));
+}
+
+void ConnectionPool::Lease::discard() {
+    if (!pool) return;
+    slot.reset();
+    pool->stats.discarded.fetch_add(1, std::memory_order_relaxed);
+    pool->forget();
+    pool = nullptr;
+}
+
+// ==========================================
+// POOL
+// ==========================================
+
+ConnectionPool::ConnectionPool(Options options) : options(std::move(options)) {
+    idle.reserve(this->options.max_size);
+}
+
+ConnectionPool::~ConnectionPool() {
+    std::lock_guard<std::mutex> lock(mutex);
+    idle.clear();
+}
+
+std::unique_ptr<ConnectionPool::PooledConnection> ConnectionPool::connect() {
+    auto slot = std::make_unique<PooledConnection>();
+    slot->conn = std::make_unique<pqxx::connection>(options.url);
+    stats.connects.fetch_add(1, std::memory_order_relaxed);
+    return slot;
+}
+
+bool ConnectionPool::healthy(pqxx::connection& conn) {
+    if (!conn.is_open()) return false;
+    try {
+        pqxx::nontransaction ping(conn);
+        ping.exec("SELECT 1");
+        return true;
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+ConnectionPool::Lease ConnectionPool::acquire() {
+    auto start = Clock::now();
+    auto deadline = start + options.checkout_timeout;
+    auto record_wait = [this, start] {
+        auto waited = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start);
+        stats.wait_us_total.fetch_add(static_cast<uint64_t>(waited.count()), std::memory_order_relaxed);
+    };
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        // 1. Reuse the warmest idle connection, pinging it first if it sat for a while
+        if (!idle.empty()) {
+            std::unique_ptr<PooledConnection> slot = std::move(idle.back());
+            idle.pop_back();
+            bool stale = Clock::now() - slot->idle_since > options.idle_check;
+            lock.unlock();
+
+            if (slot->conn->is_open() && (!stale || healthy(*slot->conn))) {
+                record_wait();
+                return hand_out(std::move(slot));
+            }
+
+            slot.reset();
+            stats.discarded.fetch_add(1, std::memory_order_relaxed);
+            lock.lock();
+            --open_count;
+            continue;
+        }
+
+        // 2. Grow the pool, unless a recent failure put connecting on hold
+        auto now = Clock::now();
+        if (open_count < options.max_size && now >= next_connect_at) {
+            ++open_count;
+            lock.unlock();
+            try {
+                auto slot = connect();
+                lock.lock();
+                backoff = std::chrono::milliseconds(0);
+                lock.unlock();
+                record_wait();
+                return hand_out(std::move(slot));
+            } catch (const std::exception& e) {
+                stats.connect_failures.fetch_add(1, std::memory_order_relaxed);
+                lock.lock();
+                --open_count;
+                backoff = std::clamp(backoff * 2, options.backoff_initial, options.backoff_max);
+                next_connect_at = Clock::now() + backoff;
+                last_error = e.what();
+                while (!last_error.empty() && last_error.back() == '\n') last_error.pop_back();
+                std::cerr << "[DATABASE] Connect failed, backing off " << backoff.count() << "ms: " << last_error << std::endl;
+                available.notify_all();
+                continue;
+            }
+        }
+
+        // 3. Wait for a lease to come back, or for the backoff to expire
+        if (now >= deadline) break;
+        auto wake = deadline;
+        if (open_count < options.max_size) wake = std::min(wake, next_connect_at);
+        available.wait_until(lock, wake);
+    }
+
+    std::string reason = last_error.empty() ? "all connections busy" : "last connect error: " + last_error;
+    lock.unlock();
+    stats.checkout_timeouts.fetch_add(1, std::memory_order_relaxed);
+    record_wait();
+    throw PoolTimeout("No database connection available within " +
+                      std::to_string(options.checkout_timeout.count()) + "ms (" + reason + ")");
+}
+
+ConnectionPool::Lease ConnectionPool::hand_out(std::unique_ptr<PooledConnection> slot) {
+    // Wrap first, so a failing prepare still returns the connection through the lease
+    Lease lease(this, std::move(slot));
+    PooledConnection& entry = *lease.slot;
+    if (entry.prepared < registry.size()) entry.prepared = registry.prepare_on(*entry.conn, entry.prepared);
+    stats.checkouts.fetch_add(1, std::memory_order_relaxed);
+    return lease;
+}
+
+void ConnectionPool::give_back(std::unique_ptr<PooledConnection> slot) {
+    // A connection that broke while leased is not worth keeping
+    if (!slot || !slot->conn->is_open()) {
+        slot.reset();
+        stats.discarded.fetch_add(1, std::memory_order_relaxed);
+        forget();
+        return;
+    }
+
+    slot->idle_since = Clock::now();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        idle.push_back(std::move(slot));
+    }
+    available.notify_one();
+}
+
+void ConnectionPool::forget() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        --open_count;
+    }
+    available.notify_one();
+}
+
+std::string ConnectionPool::to_prometheus() const {
+    size_t open;
+    size_t idle_now;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        open = open_count;
+        idle_now = idle.size();
+    }
+
+    std::ostringstream out;
+    out << "db_pool_connections_max " << options.max_size << "\n";
+    out << "db_pool_connections_open " << open << "\n";
+    out << "db_pool_connections_idle " << idle_now << "\n";
+    out << "db_pool_connections_in_use " << open - idle_now << "\n";
+    out << "db_pool_checkouts_total " << stats.checkouts.load(std::memory_order_relaxed) << "\n";
+    out << "db_pool_checkout_timeouts_total " << stats.checkout_timeouts.load(std::memory_order_relaxed) << "\n";
+    out << "db_pool_checkout_wait_microseconds_total " << stats.wait_us_total.load(std::memory_order_relaxed) << "\n";
+    out << "db_pool_connects_total " << stats.connects.load(std::memory_order_relaxed) << "\n";
+    out << "db_pool_connect_failures_total " << stats.connect_failures.load(std::memory_order_relaxed) << "\n";
+    out << "db_pool_discarded_total " << stats.discarded.load(std::memory_order_relaxed) << "\n";
+    return out.str();
+}
@@ -0,0 +1,236 @@
+#include "../include/EventStream.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+    constexpr uint32_t WATCH_EVENTS = EPOLLIN | EPOLLRDHUP;
+    constexpr std::string_view LAST_CHUNK = "0\r\n\r\n";
+
+    // A comment line: ignored by EventSource, but it keeps the connection visibly alive
+    const std::shared_ptr<const std::string> HEARTBEAT = std::make_shared<const std::string>(sse_chunk(":\n\n"));
+}
+
+std::string sse_event(std::string_view data, int64_t id) {
+    std::string event;
+    event.reserve(data.size() + 32);
+    if (id > 0) {
+        event += "id: ";
+        event += std::to_string(id);
+        event += '\n';
+    }
+
+    // A line break inside the data would end the field; split it over several data lines instead
+    size_t start = 0;
+    while (true) {
+        size_t newline = data.find('\n', start);
+        event += "data: ";
+        event += data.substr(start, newline == std::string_view::npos ? std::string_view::npos : newline - start);
+        event += '\n';
+        if (newline == std::string_view::npos) break;
+        start = newline + 1;
+    }
+    event += '\n';
+    return event;
+}
+
+std::string sse_chunk(std::string_view text) {
+    char size_line[20];
+    auto [end, ec] = std::to_chars(size_line, size_line + sizeof(size_line), text.size(), 16);
+    std::string chunk(size_line, end);
+    chunk.reserve(chunk.size() + text.size() + 4);
+    chunk += "\r\n";
+    chunk += text;
+    chunk += "\r\n";
+    return chunk;
+}
+
+Response event_stream_response(EventStreamOpen on_open) {
+    Response res;
+    res.content_type = "text/event-stream";
+    res.headers["Cache-Control"] = "no-cache";
+    res.headers["X-Accel-Buffering"] = "no";         // Tells nginx-style proxies not to hold events back
+    res.event_stream = std::move(on_open);
+    return res;
+}
+
+EventStream::EventStream(Reactor& reactor, int socket, Options options)
+    : reactor(reactor), socket(socket), options(options) {}
+
+EventStream::~EventStream() {
+    if (!closed) ::close(socket);
+}
+
+void EventStream::start(const EventStreamOpen& on_open) {
+    fcntl(socket, F_SETFL, fcntl(socket, F_GETFL, 0) | O_NONBLOCK);
+
+    std::shared_ptr<EventStream> self = shared_from_this();
+    reactor.watch(socket, WATCH_EVENTS, [self](uint32_t events) { self->handle_events(events); });
+    schedule_heartbeat();
+
+    // Sent first so the browser's EventSource fires "open" before any history arrives
+    queue(std::make_shared<const std::string>(sse_chunk("retry: " + std::to_string(options.retry.count()) + "\n\n")));
+    if (on_open && !closed) {
+        opening = true;
+        on_open(self);
+        opening = false;
+    }
+    pump();
+}
+
+void EventStream::handle_events(uint32_t events) {
+    if (closed) return;
+    if (events & (EPOLLERR | EPOLLHUP | EPOLLRDHUP)) {
+        shutdown();
+        return;
+    }
+    if (events & EPOLLIN) {
+        // The client has nothing to say on an event stream; anything it sends is discarded
+        char discard[512];
+        ssize_t received = recv(socket, discard, sizeof(discard), 0);
+        if (received == 0 || (received < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+            shutdown();
+            return;
+        }
+    }
+    if ((events & EPOLLOUT) && !flush()) shutdown();
+}
+
+void EventStream::send_event(std::string_view data, int64_t id) {
+    skip_through = std::max(skip_through, id);
+    queue(std::make_shared<const std::string>(sse_chunk(sse_event(data, id))));
+}
+
+void EventStream::resume_from(int64_t id) {
+    skip_through = std::max(skip_through, id);
+    // An id field alone updates EventSource.lastEventId without firing a message event
+    queue(std::make_shared<const std::string>(sse_chunk("id: " + std::to_string(id) + "\n\n")));
+}
+
+void EventStream::follow(FanOut& source, int64_t skip) {
+    if (closed || feed) return;
+    std::weak_ptr<EventStream> weak = weak_from_this();
+    feed_source = &source;
+    skip_through = std::max(skip_through, skip);
+    feed = source.subscribe(
+        [weak] {
+            if (std::shared_ptr<EventStream> self = weak.lock()) self->pump();
+        },
+        [weak] {
+            // Too far behind under the DISCONNECT policy; EventSource reconnects with Last-Event-ID
+            if (std::shared_ptr<EventStream> self = weak.lock()) self->end();
+        });
+}
+
+void EventStream::close() {
+    if (!open.exchange(false)) return;
+    reactor.post([self = shared_from_this()] { self->end(); });
+}
+
+void EventStream::queue(std::shared_ptr<const std::string> bytes) {
+    if (closed || ending) return;
+    // Only a backlog the peer left unread counts, so one large event still goes out. The replay
+    // queued while opening is bounded by the caller and is written before the peer could read it.
+    size_t backlog = buffered;
+    buffered += bytes->size();
+    outbox.push_back(std::move(bytes));
+    if (!opening && backlog > options.max_buffered) {
+        shutdown();
+        return;
+    }
+    if (!writing && !flush()) shutdown();
+}
+
+void EventStream::pump() {
+    if (!closed && !writing && !flush()) shutdown();
+}
+
+bool EventStream::refill() {
+    if (!feed || ending || opening) return false;
+    while (SharedFrame frame = feed->pop()) {
+        if (frame->id != 0 && frame->id <= skip_through) continue; // Already sent by the replay
+        buffered += frame->bytes.size();
+        outbox.emplace_back(frame, &frame->bytes);
+        return true;
+    }
+    return false;
+}
+
+bool EventStream::flush() {
+    while (!outbox.empty() || refill()) {
+        const std::string& bytes = *outbox.front();
+        ssize_t sent = ::send(socket, bytes.data() + outbox_offset, bytes.size() - outbox_offset, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) return false;
+            if (!writing) {
+                writing = true;
+                reactor.modify(socket, WATCH_EVENTS | EPOLLOUT);
+            }
+            return true;
+        }
+
+        wrote_since_heartbeat = true;
+        outbox_offset += static_cast<size_t>(sent);
+        buffered -= static_cast<size_t>(sent);
+        if (outbox_offset == bytes.size()) {
+            outbox.pop_front();
+            outbox_offset = 0;
+        }
+    }
+
+    if (writing) {
+        writing = false;
+        reactor.modify(socket, WATCH_EVENTS);
+    }
+    if (ending) shutdown();
+    return true;
+}
+
+void EventStream::end() {
+    if (closed || ending) return;
+    open.store(false, std::memory_order_release);
+    buffered += LAST_CHUNK.size();
+    outbox.push_back(std::make_shared<const std::string>(LAST_CHUNK));
+    ending = true;
+    if (!writing && !flush()) shutdown();
+}
+
+void EventStream::schedule_heartbeat() {
+    std::weak_ptr<EventStream> weak = weak_from_this();
+    heartbeat_timer = reactor.add_timer(Reactor::Clock::now() + options.heartbeat, [weak] {
+        std::shared_ptr<EventStream> self = weak.lock();
+        if (!self || self->closed) return;
+        self->heartbeat_timer = 0;
+
+        // Only an idle stream needs one. A write stuck for a whole interval means the peer is gone.
+        if (!self->wrote_since_heartbeat) {
+            if (self->writing) {
+                self->shutdown();
+                return;
+            }
+            self->queue(HEARTBEAT);
+        }
+        self->wrote_since_heartbeat = false;
+        if (!self->closed) self->schedule_heartbeat();
+    });
+}
+
+void EventStream::shutdown() {
+    if (closed) return;
+    closed = true;
+    open.store(false, std::memory_order_release);
+
+    reactor.unwatch(socket);
+    if (heartbeat_timer) reactor.cancel_timer(heartbeat_timer);
+    ::close(socket);
+    outbox.clear();
+    if (feed) {
+        feed_source->unsubscribe(*feed);
+        feed.reset();
+    }
+}
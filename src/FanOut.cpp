@@ -0,0 +1,120 @@
+#include "../include/FanOut.hpp"
+#include <algorithm>
+#include <sstream>
+
+FanOutSubscriber::FanOutSubscriber(size_t capacity, std::function<void()> on_ready, std::function<void()> on_overflow)
+    : slots(std::max<size_t>(capacity, 1)), on_ready(std::move(on_ready)), on_overflow(std::move(on_overflow)) {}
+
+FanOutSubscriber::Push FanOutSubscriber::push(const SharedFrame& frame) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (overflowed) return Push::QUEUED;
+    if (count == slots.size()) return Push::FULL;
+    slots[(head + count) % slots.size()] = frame;
+    ++count;
+    return Push::QUEUED;
+}
+
+void FanOutSubscriber::replace_all(const SharedFrame& frame) {
+    std::lock_guard<std::mutex> lock(mutex);
+    lost.fetch_add(count, std::memory_order_relaxed);
+    for (size_t i = 0; i < count; ++i) slots[(head + i) % slots.size()].reset();
+    head = 0;
+    slots[0] = frame;
+    count = 1;
+}
+
+SharedFrame FanOutSubscriber::pop() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (count == 0) return nullptr;
+    SharedFrame frame = std::move(slots[head]);
+    head = (head + 1) % slots.size();
+    --count;
+    return frame;
+}
+
+FanOut::FanOut(Reactor& reactor, Encoder encode, Options options)
+    : reactor(reactor), encode(std::move(encode)), options(std::move(options)) {
+    resync_frame = std::make_shared<const FanOutFrame>(FanOutFrame{0, this->encode(this->options.resync_payload, 0)});
+}
+
+std::shared_ptr<FanOutSubscriber> FanOut::subscribe(std::function<void()> on_ready, std::function<void()> on_overflow) {
+    auto subscriber = std::make_shared<FanOutSubscriber>(options.ring_capacity, std::move(on_ready), std::move(on_overflow));
+    std::lock_guard<std::mutex> lock(mutex);
+    subscribers.push_back(subscriber);
+    return subscriber;
+}
+
+void FanOut::unsubscribe(const FanOutSubscriber& subscriber) {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::erase_if(subscribers, [&subscriber](const std::shared_ptr<FanOutSubscriber>& member) {
+        return member.get() == &subscriber;
+    });
+}
+
+size_t FanOut::publish(std::string_view payload, int64_t id) {
+    // Encoded once; every subscriber queues the same bytes
+    SharedFrame frame = std::make_shared<const FanOutFrame>(FanOutFrame{id, encode(payload, id)});
+
+    std::vector<std::shared_ptr<FanOutSubscriber>> ready;
+    std::vector<std::shared_ptr<FanOutSubscriber>> overflowing;
+    size_t reached;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        reached = subscribers.size();
+        for (const std::shared_ptr<FanOutSubscriber>& subscriber : subscribers) {
+            if (subscriber->push(frame) == FanOutSubscriber::Push::FULL) {
+                switch (options.policy) {
+                    case SlowConsumerPolicy::DROP:
+                        subscriber->lost.fetch_add(1, std::memory_order_relaxed);
+                        dropped.fetch_add(1, std::memory_order_relaxed);
+                        break;
+                    case SlowConsumerPolicy::COALESCE:
+                        subscriber->replace_all(resync_frame);
+                        subscriber->lost.fetch_add(1, std::memory_order_relaxed);
+                        coalesced.fetch_add(1, std::memory_order_relaxed);
+                        break;
+                    case SlowConsumerPolicy::DISCONNECT: {
+                        std::lock_guard<std::mutex> ring_lock(subscriber->mutex);
+                        if (subscriber->overflowed) break;
+                        subscriber->overflowed = true;
+                        overflowing.push_back(subscriber);
+                        disconnected.fetch_add(1, std::memory_order_relaxed);
+                        break;
+                    }
+                }
+            }
+            // One drain per subscriber until it has run, however many frames arrive meanwhile
+            if (!subscriber->scheduled.exchange(true, std::memory_order_acq_rel)) ready.push_back(subscriber);
+        }
+    }
+    published.fetch_add(1, std::memory_order_relaxed);
+
+    if (!ready.empty() || !overflowing.empty()) {
+        reactor.post([ready = std::move(ready), overflowing = std::move(overflowing)] {
+            for (const std::shared_ptr<FanOutSubscriber>& subscriber : overflowing) {
+                if (subscriber->on_overflow) subscriber->on_overflow();
+            }
+            for (const std::shared_ptr<FanOutSubscriber>& subscriber : ready) {
+                subscriber->scheduled.store(false, std::memory_order_release);
+                if (subscriber->on_ready) subscriber->on_ready();
+            }
+        });
+    }
+    return reached;
+}
+
+size_t FanOut::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return subscribers.size();
+}
+
+std::string FanOut::to_prometheus() const {
+    std::string label = "{channel=\"" + options.name + "\"}";
+    std::ostringstream out;
+    out << "chat_fanout_subscribers" << label << " " << size() << "\n";
+    out << "chat_fanout_published_total" << label << " " << published.load(std::memory_order_relaxed) << "\n";
+    out << "chat_fanout_dropped_total" << label << " " << dropped.load(std::memory_order_relaxed) << "\n";
+    out << "chat_fanout_coalesced_total" << label << " " << coalesced.load(std::memory_order_relaxed) << "\n";
+    out << "chat_fanout_disconnected_total" << label << " " << disconnected.load(std::memory_order_relaxed) << "\n";
+    return out.str();
+}
@@ -0,0 +1,652 @@
+#include "../include/Json.hpp"
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace {
+    constexpr size_t BLOCK_SIZE = 64;
+
+    // Deeper documents are rejected, so recursive consumers of the tape stay within the stack
+    constexpr size_t MAX_DEPTH = 512;
+
+    // Per-byte classification of one 64-byte block, one bit per input byte.
+    struct BlockMasks {
+        uint64_t backslash = 0;
+        uint64_t quote = 0;
+        uint64_t op = 0;          // { } [ ] : ,
+        uint64_t whitespace = 0;  // space, \t, \n, \r
+    };
+
+#if defined(__SSE2__)
+    inline uint64_t lane_bits(__m128i cmp, int lane) {
+        return static_cast<uint64_t>(static_cast<uint32_t>(_mm_movemask_epi8(cmp))) << (16 * lane);
+    }
+
+    BlockMasks classify(const char* p) {
+        BlockMasks m;
+        for (int lane = 0; lane < 4; ++lane) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16 * lane));
+            // OR-ing 0x20 folds '[' onto '{' and ']' onto '}'
+            __m128i folded = _mm_or_si128(v, _mm_set1_epi8(0x20));
+            __m128i op = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(folded, _mm_set1_epi8('{')), _mm_cmpeq_epi8(folded, _mm_set1_epi8('}'))),
+                _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(':')), _mm_cmpeq_epi8(v, _mm_set1_epi8(','))));
+            __m128i ws = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))),
+                _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\r'))));
+
+            m.backslash |= lane_bits(_mm_cmpeq_epi8(v, _mm_set1_epi8('\\')), lane);
+            m.quote |= lane_bits(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')), lane);
+            m.op |= lane_bits(op, lane);
+            m.whitespace |= lane_bits(ws, lane);
+        }
+        return m;
+    }
+#else
+    BlockMasks classify(const char* p) {
+        BlockMasks m;
+        for (size_t i = 0; i < BLOCK_SIZE; ++i) {
+            uint64_t bit = uint64_t{1} << i;
+            switch (p[i]) {
+                case '\\': m.backslash |= bit; break;
+                case '"': m.quote |= bit; break;
+                case '{': case '}': case '[': case ']': case ':': case ',': m.op |= bit; break;
+                case ' ': case '\t': case '\n': case '\r': m.whitespace |= bit; break;
+                default: break;
+            }
+        }
+        return m;
+    }
+#endif
+
+    // Bit i of the result is the XOR of bits 0..i of x: turns quote positions into string interiors.
+    inline uint64_t prefix_xor(uint64_t x) {
+        x ^= x << 1;
+        x ^= x << 2;
+        x ^= x << 4;
+        x ^= x << 8;
+        x ^= x << 16;
+        x ^= x << 32;
+        return x;
+    }
+
+    // Marks every byte escaped by a backslash, carrying an unfinished escape into the next block.
+    inline uint64_t escaped_bytes(uint64_t backslash, uint64_t& next_is_escaped) {
+        constexpr uint64_t EVEN_BITS = 0x5555555555555555ULL;
+
+        backslash &= ~next_is_escaped;
+        uint64_t follows_escape = (backslash << 1) | next_is_escaped;
+        uint64_t odd_sequence_starts = backslash & ~EVEN_BITS & ~follows_escape;
+
+        uint64_t sequences_starting_on_even_bits;
+        next_is_escaped = __builtin_add_overflow(odd_sequence_starts, backslash, &sequences_starting_on_even_bits) ? 1 : 0;
+        uint64_t invert_mask = sequences_starting_on_even_bits << 1;
+
+        return (EVEN_BITS ^ invert_mask) & follows_escape;
+    }
+
+    // Bytes that terminate a number or literal.
+    constexpr std::array<bool, 256> DELIMITERS = [] {
+        std::array<bool, 256> table{};
+        for (unsigned char c : std::string_view("{}[]:,\" \t\n\r")) table[c] = true;
+        return table;
+    }();
+
+    inline bool is_digit(char c) { return c >= '0' && c <= '9'; }
+
+    // Validates the RFC 8259 number grammar: -?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)?
+    bool is_json_number(std::string_view s) {
+        size_t i = 0;
+        if (i < s.size() && s[i] == '-') ++i;
+        if (i >= s.size()) return false;
+        if (s[i] == '0') {
+            ++i;
+        } else if (is_digit(s[i])) {
+            while (i < s.size() && is_digit(s[i])) ++i;
+        } else {
+            return false;
+        }
+        if (i < s.size() && s[i] == '.') {
+            size_t start = ++i;
+            while (i < s.size() && is_digit(s[i])) ++i;
+            if (i == start) return false;
+        }
+        if (i < s.size() && (s[i] == 'e' || s[i] == 'E')) {
+            ++i;
+            if (i < s.size() && (s[i] == '+' || s[i] == '-')) ++i;
+            size_t start = i;
+            while (i < s.size() && is_digit(s[i])) ++i;
+            if (i == start) return false;
+        }
+        return i == s.size();
+    }
+
+    void append_utf8(std::string& out, uint32_t cp) {
+        if (cp < 0x80) {
+            out += static_cast<char>(cp);
+        } else if (cp < 0x800) {
+            out += static_cast<char>(0xC0 | (cp >> 6));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        } else if (cp < 0x10000) {
+            out += static_cast<char>(0xE0 | (cp >> 12));
+            out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        } else {
+            out += static_cast<char>(0xF0 | (cp >> 18));
+            out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        }
+    }
+
+    bool parse_hex4(std::string_view s, size_t pos, uint32_t& value) {
+        if (pos + 4 > s.size()) return false;
+        auto [ptr, ec] = std::from_chars(s.data() + pos, s.data() + pos + 4, value, 16);
+        return ec == std::errc() && ptr == s.data() + pos + 4;
+    }
+}
+
+std::string json_unescape(std::string_view raw) {
+    std::string out;
+    out.reserve(raw.size());
+
+    for (size_t i = 0; i < raw.size(); ++i) {
+        // Copy the run up to the next escape in one go
+        size_t next = raw.find('\\', i);
+        if (next == std::string_view::npos) next = raw.size();
+        out.append(raw.substr(i, next - i));
+        i = next;
+        if (i + 1 >= raw.size()) {
+            if (i < raw.size()) out += raw[i];
+            break;
+        }
+
+        char esc = raw[++i];
+        switch (esc) {
+            case '"': out += '"'; break;
+            case '\\': out += '\\'; break;
+            case '/': out += '/'; break;
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'n': out += '\n'; break;
+            case 'r': out += '\r'; break;
+            case 't': out += '\t'; break;
+            case 'u': {
+                uint32_t cp = 0;
+                if (!parse_hex4(raw, i + 1, cp)) {
+                    out += "\\u";
+                    break;
+                }
+                i += 4;
+                // Combine UTF-16 surrogate pairs into one code point
+                uint32_t low = 0;
+                if (cp >= 0xD800 && cp <= 0xDBFF && i + 2 < raw.size() && raw[i + 1] == '\\' &&
+                    raw[i + 2] == 'u' && parse_hex4(raw, i + 3, low) && low >= 0xDC00 && low <= 0xDFFF) {
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                    i += 6;
+                } else if (cp >= 0xD800 && cp <= 0xDFFF) {
+                    cp = 0xFFFD; // Lone surrogate: emit the replacement character
+                }
+                append_utf8(out, cp);
+                break;
+            }
+            default:
+                out += '\\';
+                out += esc;
+                break;
+        }
+    }
+    return out;
+}
+
+// ==========================================
+// JsonDocument
+// ==========================================
+
+bool JsonDocument::fail(std::string_view message) {
+    tape.clear();
+    error_message = message;
+    return false;
+}
+
+bool JsonDocument::parse(std::string_view json) {
+    source.assign(json);
+    structural_count = 0;
+    tape.clear();
+    error_message.clear();
+
+    if (json.size() >= UINT32_MAX) return fail("document too large");
+    if (!index_structurals()) return false;
+    return build_tape();
+}
+
+bool JsonDocument::index_structurals() {
+    const size_t n = source.size();
+
+    // Every byte may be structural; one extra block lets the writer below run without bounds checks
+    size_t needed = n + BLOCK_SIZE;
+    if (structural_capacity < needed) {
+        structurals.reset(new uint32_t[needed]);
+        structural_capacity = needed;
+    }
+    uint32_t* out = structurals.get();
+
+    uint64_t next_is_escaped = 0;
+    uint64_t prev_in_string = 0;
+    uint64_t prev_scalar = 0;
+    char tail[BLOCK_SIZE];
+
+    for (size_t base = 0; base < n; base += BLOCK_SIZE) {
+        const char* block = source.data() + base;
+        size_t valid = std::min(BLOCK_SIZE, n - base);
+
+        // The final partial block is padded with whitespace, which never changes the result
+        if (valid < BLOCK_SIZE) {
+            std::memset(tail, ' ', BLOCK_SIZE);
+            std::memcpy(tail, block, valid);
+            block = tail;
+        }
+
+        BlockMasks m = classify(block);
+
+        // 1. Resolve escapes, then string interiors (opening quote through the byte before the closing one)
+        uint64_t quotes = m.quote & ~escaped_bytes(m.backslash, next_is_escaped);
+        uint64_t in_string = prefix_xor(quotes) ^ prev_in_string;
+        prev_in_string = static_cast<uint64_t>(static_cast<int64_t>(in_string) >> 63);
+
+        // 2. Scalars (numbers, literals) start where a run of non-delimiter bytes outside strings starts
+        uint64_t scalar = ~(m.op | m.whitespace | quotes) & ~in_string;
+        uint64_t scalar_starts = scalar & ~((scalar << 1) | prev_scalar);
+        prev_scalar = scalar >> 63;
+
+        uint64_t bits = (m.op & ~in_string) | quotes | scalar_starts;
+        if (valid < BLOCK_SIZE) bits &= (uint64_t{1} << valid) - 1;
+
+        // Write offsets unconditionally in groups of four; slots past the popcount are overwritten later
+        int count = __builtin_popcountll(bits);
+        uint32_t* dst = out;
+        while (bits) {
+            for (int k = 0; k < 4; ++k) {
+                dst[k] = static_cast<uint32_t>(base) + static_cast<uint32_t>(__builtin_ctzll(bits | (uint64_t{1} << 63)));
+                bits &= bits - 1;
+            }
+            dst += 4;
+        }
+        out += count;
+    }
+    structural_count = static_cast<size_t>(out - structurals.get());
+
+    if (prev_in_string) return fail("unterminated string");
+    return true;
+}
+
+bool JsonDocument::build_tape() {
+    struct Frame {
+        uint32_t tape_index;
+        bool object;
+    };
+
+    const char* src = source.data();
+    const uint32_t* idx = structurals.get();
+    const uint32_t* const last = idx + structural_count;
+    std::vector<Frame> stack;
+    stack.reserve(64);
+    tape.reserve(structural_count / 2 + 1);
+    char c = 0;
+
+    // Appends a string (opening and closing quotes are adjacent structurals) or a literal/number
+    auto push_primitive = [&]() -> bool {
+        uint32_t pos = *idx;
+        TapeEntry entry;
+
+        if (src[pos] == '"') {
+            if (idx + 1 == last) return fail("unterminated string");
+            entry.type = JsonType::STRING;
+            entry.offset = pos + 1;
+            entry.length = idx[1] - pos - 1;
+            entry.escaped = std::memchr(src + entry.offset, '\\', entry.length) != nullptr;
+            idx += 2;
+        } else {
+            uint32_t end = pos;
+            while (end < source.size() && !DELIMITERS[static_cast<uint8_t>(src[end])]) ++end;
+            std::string_view text(src + pos, end - pos);
+
+            if (text == "true" || text == "false") {
+                entry.type = JsonType::BOOLEAN;
+            } else if (text == "null") {
+                entry.type = JsonType::NUL;
+            } else if (is_json_number(text)) {
+                entry.type = JsonType::NUMBER;
+            } else {
+                return fail(DELIMITERS[static_cast<uint8_t>(src[pos])] ? "expected a value" : "invalid literal");
+            }
+            entry.offset = pos;
+            entry.length = end - pos;
+            ++idx;
+        }
+
+        entry.next = static_cast<uint32_t>(tape.size() + 1);
+        tape.push_back(entry);
+        return true;
+    };
+
+    auto open_container = [&](JsonType type) -> bool {
+        if (stack.size() == MAX_DEPTH) return fail("nesting too deep");
+        TapeEntry entry;
+        entry.type = type;
+        entry.offset = *idx++;
+        stack.push_back({static_cast<uint32_t>(tape.size()), type == JsonType::OBJECT});
+        tape.push_back(entry);
+        return true;
+    };
+
+    // The grammar is walked with direct jumps between states, as in simdjson's stage 2:
+    // every structural is visited exactly once and no per-token state variable is dispatched on.
+    if (idx == last) return fail("empty document");
+    c = src[*idx];
+    if (c == '{') goto object_begin;
+    if (c == '[') goto array_begin;
+    if (!push_primitive()) return false;
+    goto document_end;
+
+object_begin:
+    if (!open_container(JsonType::OBJECT)) return false;
+    if (idx == last) return fail("unexpected end of document");
+    if (src[*idx] == '}') {
+        ++idx;
+        goto scope_end;
+    }
+
+object_field:
+    if (idx == last || src[*idx] != '"') return fail("expected an object key");
+    if (!push_primitive()) return false;
+    if (idx == last || src[*idx] != ':') return fail("expected ':'");
+    if (++idx == last) return fail("unexpected end of document");
+    ++tape[stack.back().tape_index].count;
+    c = src[*idx];
+    if (c == '{') goto object_begin;
+    if (c == '[') goto array_begin;
+    if (!push_primitive()) return false;
+
+object_continue:
+    if (idx == last) return fail("unexpected end of document");
+    c = src[*idx++];
+    if (c == ',') goto object_field;
+    if (c == '}') goto scope_end;
+    return fail("expected ',' or '}'");
+
+array_begin:
+    if (!open_container(JsonType::ARRAY)) return false;
+    if (idx == last) return fail("unexpected end of document");
+    if (src[*idx] == ']') {
+        ++idx;
+        goto scope_end;
+    }
+
+array_value:
+    if (idx == last) return fail("unexpected end of document");
+    ++tape[stack.back().tape_index].count;
+    c = src[*idx];
+    if (c == '{') goto object_begin;
+    if (c == '[') goto array_begin;
+    if (!push_primitive()) return false;
+
+array_continue:
+    if (idx == last) return fail("unexpected end of document");
+    c = src[*idx++];
+    if (c == ',') goto array_value;
+    if (c == ']') goto scope_end;
+    return fail("expected ',' or ']'");
+
+scope_end:
+    tape[stack.back().tape_index].next = static_cast<uint32_t>(tape.size());
+    stack.pop_back();
+    if (stack.empty()) goto document_end;
+    if (stack.back().object) goto object_continue;
+    goto array_continue;
+
+document_end:
+    if (idx != last) return fail("trailing characters after the document");
+    return true;
+}
+
+// ==========================================
+// JsonValue
+// ==========================================
+
+JsonType JsonValue::type() const {
+    return doc ? doc->tape[index].type : JsonType::INVALID;
+}
+
+std::string_view JsonValue::raw() const {
+    if (!doc) return {};
+    const auto& entry = doc->tape[index];
+    if (entry.type == JsonType::OBJECT || entry.type == JsonType::ARRAY) return {};
+    return std::string_view(doc->source).substr(entry.offset, entry.length);
+}
+
+std::string JsonValue::as_string() const {
+    if (!doc) return {};
+    if (doc->tape[index].escaped) return json_unescape(raw());
+    return std::string(raw());
+}
+
+double JsonValue::as_double(double fallback) const {
+    if (type() != JsonType::NUMBER) return fallback;
+    std::string_view text = raw();
+    double value = fallback;
+    std::from_chars(text.data(), text.data() + text.size(), value);
+    return value;
+}
+
+int64_t JsonValue::as_int(int64_t fallback) const {
+    if (type() != JsonType::NUMBER) return fallback;
+    std::string_view text = raw();
+    int64_t value = 0;
+    auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (ec == std::errc() && ptr == text.data() + text.size()) return value;
+    return static_cast<int64_t>(as_double(static_cast<double>(fallback)));
+}
+
+bool JsonValue::as_bool() const {
+    return type() == JsonType::BOOLEAN && raw() == "true";
+}
+
+size_t JsonValue::size() const {
+    if (!doc) return 0;
+    const auto& entry = doc->tape[index];
+    return (entry.type == JsonType::OBJECT || entry.type == JsonType::ARRAY) ? entry.count : 0;
+}
+
+JsonValue JsonValue::operator[](std::string_view key) const {
+    if (!is_object()) return {};
+    for (auto it = begin(); it != end(); ++it) {
+        JsonValue k = it.key();
+        bool match = doc->tape[k.index].escaped ? k.as_string() == key : k.raw() == key;
+        if (match) return it.value();
+    }
+    return {};
+}
+
+JsonValue JsonValue::operator[](size_t position) const {
+    if (!is_array() || position >= size()) return {};
+    auto it = begin();
+    for (size_t i = 0; i < position; ++i) ++it;
+    return *it;
+}
+
+JsonValue::iterator JsonValue::begin() const {
+    if (!is_object() && !is_array()) return end();
+    return {doc, index + 1, is_object()};
+}
+
+JsonValue::iterator JsonValue::end() const {
+    if (!doc) return {nullptr, 0, false};
+    if (!is_object() && !is_array()) return {doc, index, false};
+    return {doc, doc->tape[index].next, is_object()};
+}
+
+JsonValue JsonValue::iterator::key() const {
+    return object ? JsonValue(doc, index) : JsonValue();
+}
+
+JsonValue JsonValue::iterator::value() const {
+    return JsonValue(doc, object ? index + 1 : index);
+}
+
+JsonValue::iterator& JsonValue::iterator::operator++() {
+    // Every tape entry records where its subtree ends, so nested values are skipped in one jump
+    uint32_t value_index = object ? index + 1 : index;
+    index = doc->tape[value_index].next;
+    return *this;
+}
+
+// ==========================================
+// JsonWriter
+// ==========================================
+
+namespace {
+    // Bytes that cannot appear raw inside a JSON string.
+    constexpr std::array<bool, 256> NEEDS_ESCAPE = [] {
+        std::array<bool, 256> table{};
+        for (int c = 0; c < 0x20; ++c) table[c] = true;
+        table['"'] = true;
+        table['\\'] = true;
+        return table;
+    }();
+}
+
+void JsonWriter::separator() {
+    if (after_key) {
+        after_key = false;
+        return;
+    }
+    if (!has_items.empty()) {
+        if (has_items.back()) out += ',';
+        has_items.back() = 1;
+    }
+}
+
+void JsonWriter::write_string(std::string_view text) {
+    static constexpr char HEX[] = "0123456789abcdef";
+    out += '"';
+
+    size_t run_start = 0;
+    for (size_t i = 0; i < text.size(); ++i) {
+        auto c = static_cast<unsigned char>(text[i]);
+        if (!NEEDS_ESCAPE[c]) continue;
+
+        // Flush the run of safe bytes before the escape in one append
+        out.append(text.data() + run_start, i - run_start);
+        run_start = i + 1;
+
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            case '\b': out += "\\b"; break;
+            case '\f': out += "\\f"; break;
+            default: {
+                char esc[6] = {'\\', 'u', '0', '0', HEX[c >> 4], HEX[c & 0xF]};
+                out.append(esc, sizeof(esc));
+                break;
+            }
+        }
+    }
+
+    out.append(text.data() + run_start, text.size() - run_start);
+    out += '"';
+}
+
+JsonWriter& JsonWriter::begin_object() {
+    separator();
+    out += '{';
+    has_items.push_back(0);
+    return *this;
+}
+
+JsonWriter& JsonWriter::end_object() {
+    out += '}';
+    if (!has_items.empty()) has_items.pop_back();
+    return *this;
+}
+
+JsonWriter& JsonWriter::begin_array() {
+    separator();
+    out += '[';
+    has_items.push_back(0);
+    return *this;
+}
+
+JsonWriter& JsonWriter::end_array() {
+    out += ']';
+    if (!has_items.empty()) has_items.pop_back();
+    return *this;
+}
+
+JsonWriter& JsonWriter::key(std::string_view name) {
+    separator();
+    write_string(name);
+    out += ':';
+    after_key = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(std::string_view text) {
+    separator();
+    write_string(text);
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(bool flag) {
+    separator();
+    out += flag ? "true" : "false";
+    return *this;
+}
+
+JsonWriter& JsonWriter::write_signed(int64_t number) {
+    separator();
+    char buf[24];
+    auto [ptr, ec] = std::to_chars(buf, buf + sizeof(buf), number);
+    out.append(buf, ptr);
+    return *this;
+}
+
+JsonWriter& JsonWriter::write_unsigned(uint64_t number) {
+    separator();
+    char buf[24];
+    auto [ptr, ec] = std::to_chars(buf, buf + sizeof(buf), number);
+    out.append(buf, ptr);
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(double number) {
+    // JSON has no representation for NaN or infinities
+    if (!std::isfinite(number)) return null();
+    separator();
+    char buf[32];
+    auto [ptr, ec] = std::to_chars(buf, buf + sizeof(buf), number);
+    out.append(buf, ptr);
+    return *this;
+}
+
+JsonWriter& JsonWriter::null() {
+    separator();
+    out += "null";
+    return *this;
+}
+
+JsonWriter& JsonWriter::raw(std::string_view json) {
+    separator();
+    out.append(json);
+    return *this;
+}
@@ -0,0 +1,72 @@
+#include "../include/LongPoll.hpp"
+#include <algorithm>
+
+LongPollHub::LongPollHub(Renderer render, size_t max_batch) : render(std::move(render)), max_batch(max_batch) {}
+
+bool LongPollHub::delta(const MessageSnapshot& snapshot, int64_t after_id, std::vector<Message>& delta,
+                        bool& has_more) const {
+    const std::vector<Message>& messages = snapshot.messages;
+    if (messages.empty() || messages.back().id <= after_id) return false;
+
+    auto first = std::upper_bound(messages.begin(), messages.end(), after_id,
+                                  [](int64_t id, const Message& message) { return id < message.id; });
+    size_t available = static_cast<size_t>(messages.end() - first);
+    size_t count = std::min(available, max_batch);
+    delta.assign(first, first + static_cast<std::ptrdiff_t>(count));
+
+    // Ids are dense in practice; a jump right after the client's id means the cache was trimmed
+    // past it, and the client should page through /api/messages to fill the gap
+    has_more = count < available || (first == messages.begin() && first->id > after_id + 1);
+    return true;
+}
+
+void LongPollHub::answer(const MessageSnapshot& snapshot, const Waiter& waiter) const {
+    std::vector<Message> messages;
+    bool has_more = false;
+    if (delta(snapshot, waiter.after_id, messages, has_more)) {
+        waiter.pending->complete(render(messages, has_more));
+    }
+}
+
+void LongPollHub::wait(int64_t after_id, const std::shared_ptr<PendingResponse>& pending, const MessageCache& cache) {
+    std::shared_ptr<const MessageSnapshot> snapshot;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        snapshot = cache.snapshot();
+        if (snapshot->messages.empty() || snapshot->messages.back().id <= after_id) {
+            // Disconnected and timed-out waiters are only dropped here and in notify()
+            if (waiters.size() >= sweep_at) {
+                std::erase_if(waiters, [](const Waiter& waiter) { return waiter.pending->finished(); });
+                sweep_at = std::max<size_t>(64, waiters.size() * 2);
+            }
+            waiters.push_back({after_id, pending});
+            return;
+        }
+    }
+    answer(*snapshot, {after_id, pending});
+}
+
+void LongPollHub::notify(const MessageSnapshot& snapshot) {
+    if (snapshot.messages.empty()) return;
+    int64_t newest = snapshot.messages.back().id;
+
+    std::vector<Waiter> ready;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto keep = std::partition(waiters.begin(), waiters.end(), [newest](const Waiter& waiter) {
+            return waiter.after_id >= newest && !waiter.pending->finished();
+        });
+        ready.assign(std::make_move_iterator(keep), std::make_move_iterator(waiters.end()));
+        waiters.erase(keep, waiters.end());
+    }
+
+    // Rendering and completing happen outside the lock, so new waiters are not held up
+    for (const Waiter& waiter : ready) {
+        if (!waiter.pending->finished()) answer(snapshot, waiter);
+    }
+}
+
+size_t LongPollHub::waiting() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return waiters.size();
+}
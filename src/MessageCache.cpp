@@ -0,0 +1,52 @@
+#include "../include/MessageCache.hpp"
+#include <algorithm>
+
+MessageCache::MessageCache(size_t capacity)
+    : capacity(capacity), current(std::make_shared<const MessageSnapshot>()) {}
+
+std::vector<Message> MessageCache::publish(std::vector<Message> messages) {
+    return merge(std::move(messages), false);
+}
+
+void MessageCache::fill(std::vector<Message> messages) {
+    merge(std::move(messages), true);
+}
+
+std::vector<Message> MessageCache::merge(std::vector<Message> messages, bool loaded) {
+    auto by_id = [](const Message& a, const Message& b) { return a.id < b.id; };
+    auto same_id = [](const Message& a, const Message& b) { return a.id == b.id; };
+    std::sort(messages.begin(), messages.end(), by_id);
+    messages.erase(std::unique(messages.begin(), messages.end(), same_id), messages.end());
+
+    std::lock_guard<std::mutex> lock(writer);
+    std::shared_ptr<const MessageSnapshot> old = snapshot();
+
+    // Keep only what is new; the writer lock makes the check and the swap one step
+    std::erase_if(messages, [&old, &by_id](const Message& message) {
+        return std::binary_search(old->messages.begin(), old->messages.end(), message, by_id);
+    });
+    if (messages.empty() && (!loaded || old->loaded)) return {};
+
+    auto next = std::make_shared<MessageSnapshot>();
+    next->version = old->version + 1;
+    next->loaded = old->loaded || loaded;
+
+    // Both sides are sorted and disjoint; merge them, then keep only the newest entries
+    next->messages.reserve(old->messages.size() + messages.size());
+    std::merge(old->messages.begin(), old->messages.end(), messages.begin(), messages.end(),
+               std::back_inserter(next->messages), by_id);
+    if (next->messages.size() > capacity) {
+        next->messages.erase(next->messages.begin(),
+                             next->messages.end() - static_cast<std::ptrdiff_t>(capacity));
+        int64_t oldest = next->messages.front().id;
+        std::erase_if(messages, [oldest](const Message& message) { return message.id < oldest; });
+    }
+
+    // Only the pointer swap is locked; the old snapshot is freed by whoever drops it last
+    std::shared_ptr<const MessageSnapshot> published(std::move(next));
+    {
+        std::lock_guard<std::mutex> swap_lock(swap_mutex);
+        current.swap(published);
+    }
+    return messages;
+}
@@ -0,0 +1,15 @@
+#include "../include/Middleware.hpp"
+
+std::string HttpMetrics::to_prometheus() const {
+	std::string out;
+	out += "http_requests_total " + std::to_string(requests.load(std::memory_order_relaxed)) + "\n";
+
+	for (int i = 0; i < 5; ++i) {
+		out += "http_responses_total{class=\"" + std::to_string(i + 1) + "xx\"} " +
+		       std::to_string(responses_by_class[i].load(std::memory_order_relaxed)) + "\n";
+	}
+
+	out += "http_handler_latency_microseconds_total " +
+	       std::to_string(latency_us_total.load(std::memory_order_relaxed)) + "\n";
+	return out;
+}
@@ -0,0 +1,77 @@
+#include "../include/Migrations.hpp"
+#include <algorithm>
+#include <iostream>
+#include <set>
+#include <stdexcept>
+
+namespace {
+    // Arbitrary application-wide key for pg_advisory_lock; only has to differ from other users of the database
+    constexpr const char* LOCK_KEY = "4815162342";
+
+    void unlock(pqxx::connection& conn) {
+        pqxx::nontransaction N(conn);
+        N.exec(std::string("SELECT pg_advisory_unlock(") + LOCK_KEY + ")");
+    }
+}
+
+int run_migrations(pqxx::connection& conn, std::vector<Migration> migrations) {
+    std::sort(migrations.begin(), migrations.end(),
+              [](const Migration& a, const Migration& b) { return a.version < b.version; });
+    auto duplicate = std::adjacent_find(migrations.begin(), migrations.end(),
+                                        [](const Migration& a, const Migration& b) { return a.version == b.version; });
+    if (duplicate != migrations.end()) {
+        throw std::invalid_argument("Duplicate migration version " + std::to_string(duplicate->version));
+    }
+
+    // Waits while another replica migrates; it holds the lock until it is done
+    {
+        pqxx::nontransaction N(conn);
+        N.exec(std::string("SELECT pg_advisory_lock(") + LOCK_KEY + ")");
+    }
+
+    int applied = 0;
+    try {
+        {
+            pqxx::work W(conn);
+            W.exec(R"(
+                CREATE TABLE IF NOT EXISTS schema_migrations (
+                    version INTEGER PRIMARY KEY,
+                    name TEXT NOT NULL,
+                    applied_at TIMESTAMP NOT NULL DEFAULT CURRENT_TIMESTAMP
+                )
+            )");
+            W.commit();
+        }
+
+        std::set<int> done;
+        {
+            pqxx::nontransaction N(conn);
+            for (auto row : N.exec("SELECT version FROM schema_migrations")) {
+                done.insert(row[0].as<int>());
+            }
+        }
+
+        for (const Migration& migration : migrations) {
+            if (done.count(migration.version)) continue;
+            std::cout << "[DATABASE] Applying migration " << migration.version << " (" << migration.name << ")"
+                      << std::endl;
+
+            pqxx::work W(conn);
+            W.exec(migration.sql);
+            W.exec_params("INSERT INTO schema_migrations (version, name) VALUES ($1, $2)",
+                          migration.version, migration.name);
+            W.commit();
+            ++applied;
+        }
+    } catch (...) {
+        // The lock also ends with the session, so a failed unlock on a broken connection is harmless
+        try {
+            unlock(conn);
+        } catch (const std::exception&) {
+        }
+        throw;
+    }
+
+    unlock(conn);
+    return applied;
+}
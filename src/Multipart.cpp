@@ -0,0 +1,287 @@
+#include "../include/Multipart.hpp"
+#include <cerrno>
+#include <cstdlib>
+#include <fcntl.h>
+#include <strings.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr std::string_view CRLF = "\r\n";
+constexpr std::string_view HEADER_END = "\r\n\r\n";
+constexpr size_t MAX_BOUNDARY_LENGTH = 70;  ///< RFC 2046, section 5.1.1
+
+std::string_view trim(std::string_view text) {
+    size_t start = text.find_first_not_of(" \t");
+    if (start == std::string_view::npos) return {};
+    size_t end = text.find_last_not_of(" \t");
+    return text.substr(start, end - start + 1);
+}
+
+bool iequals(std::string_view a, std::string_view b) {
+    return a.size() == b.size() && strncasecmp(a.data(), b.data(), a.size()) == 0;
+}
+
+/**
+ * @brief Reads a header parameter value: a token, or a quoted string with backslash escapes.
+ */
+std::string parameter_value(std::string_view raw) {
+    raw = trim(raw);
+    if (raw.empty() || raw.front() != '"') return std::string(raw);
+
+    std::string value;
+    for (size_t i = 1; i < raw.size() && raw[i] != '"'; ++i) {
+        if (raw[i] == '\\' && i + 1 < raw.size()) ++i;
+        value += raw[i];
+    }
+    return value;
+}
+
+/**
+ * @brief Splits "type; a=1; b=\"x;y\"" into parameters, honouring quotes, and calls fn(name, value).
+ */
+template <typename Fn>
+void for_each_parameter(std::string_view header, Fn&& fn) {
+    size_t pos = header.find(';');
+    while (pos != std::string_view::npos) {
+        size_t start = pos + 1;
+        bool quoted = false;
+        size_t end = start;
+        for (; end < header.size(); ++end) {
+            if (header[end] == '\\' && quoted) {
+                ++end;
+            } else if (header[end] == '"') {
+                quoted = !quoted;
+            } else if (header[end] == ';' && !quoted) {
+                break;
+            }
+        }
+
+        std::string_view param = header.substr(start, std::min(end, header.size()) - start);
+        size_t eq = param.find('=');
+        if (eq != std::string_view::npos) fn(trim(param.substr(0, eq)), param.substr(eq + 1));
+        pos = end < header.size() ? end : std::string_view::npos;
+    }
+}
+
+} // namespace
+
+// ==========================================
+// MULTIPART PARSER
+// ==========================================
+
+MultipartParser::MultipartParser(std::string_view boundary, Callbacks callbacks)
+    : delimiter("\r\n--" + std::string(boundary)),
+      searcher(delimiter.begin(), delimiter.end()),
+      callbacks(std::move(callbacks)),
+      pending(CRLF) {
+    // The leading CRLF belongs to the delimiter, but the very first boundary may start the body;
+    // seeding the buffer with a virtual CRLF lets one search pattern cover both cases
+}
+
+std::string MultipartParser::boundary_from_content_type(std::string_view content_type) {
+    std::string boundary;
+    for_each_parameter(content_type, [&](std::string_view name, std::string_view value) {
+        if (iequals(name, "boundary")) boundary = parameter_value(value);
+    });
+    if (boundary.size() > MAX_BOUNDARY_LENGTH) boundary.clear();
+    return boundary;
+}
+
+size_t MultipartParser::find_delimiter(std::string_view data) const {
+    auto [first, last] = searcher(data.begin(), data.end());
+    return first == data.end() ? std::string_view::npos : static_cast<size_t>(first - data.begin());
+}
+
+bool MultipartParser::fail(std::string_view message) {
+    state = State::FAILED;
+    error_message = message;
+    pending.clear();
+    return false;
+}
+
+bool MultipartParser::parse_part_headers(std::string_view headers) {
+    part = MultipartPartInfo{};
+    bool has_disposition = false;
+
+    while (!headers.empty()) {
+        size_t eol = headers.find(CRLF);
+        std::string_view line = headers.substr(0, eol);
+        headers = eol == std::string_view::npos ? std::string_view{} : headers.substr(eol + CRLF.size());
+
+        size_t colon = line.find(':');
+        if (colon == std::string_view::npos) return fail("malformed part header");
+        std::string_view name = trim(line.substr(0, colon));
+        std::string_view value = trim(line.substr(colon + 1));
+
+        if (iequals(name, "Content-Disposition")) {
+            has_disposition = true;
+            for_each_parameter(value, [&](std::string_view param, std::string_view raw) {
+                if (iequals(param, "name")) {
+                    part.name = parameter_value(raw);
+                } else if (iequals(param, "filename")) {
+                    part.filename = parameter_value(raw);
+                }
+            });
+        } else if (iequals(name, "Content-Type")) {
+            part.content_type = std::string(value);
+        }
+    }
+
+    if (!has_disposition || part.name.empty()) return fail("part without a form field name");
+    return true;
+}
+
+bool MultipartParser::feed(std::string_view chunk) {
+    if (state == State::FAILED) return false;
+    if (state == State::DONE) return true;  // The epilogue is ignored
+
+    pending.append(chunk);
+    std::string_view data(pending);
+    size_t pos = 0;
+
+    while (true) {
+        switch (state) {
+            case State::PREAMBLE: {
+                size_t found = find_delimiter(data.substr(pos));
+                if (found == std::string_view::npos) {
+                    // Keep just enough to recognize a delimiter split across two chunks
+                    if (data.size() - pos >= delimiter.size()) pos = data.size() - (delimiter.size() - 1);
+                    goto done;
+                }
+                pos += found + delimiter.size();
+                state = State::AFTER_BOUNDARY;
+                break;
+            }
+
+            case State::AFTER_BOUNDARY: {
+                // Transport padding may follow the boundary before its line break
+                while (pos < data.size() && (data[pos] == ' ' || data[pos] == '\t')) ++pos;
+                if (data.size() - pos < 2) goto done;
+                if (data.substr(pos, 2) == "--") {
+                    state = State::DONE;
+                    pending.clear();
+                    return true;
+                }
+                if (data.substr(pos, 2) != CRLF) return fail("boundary not followed by a line break");
+                pos += 2;
+                state = State::HEADERS;
+                break;
+            }
+
+            case State::HEADERS: {
+                // A part without headers starts its body right away
+                if (data.size() - pos >= 2 && data.substr(pos, 2) == CRLF) {
+                    if (!parse_part_headers({})) return false;
+                    pos += 2;
+                } else {
+                    size_t end = data.find(HEADER_END, pos);
+                    if (end == std::string_view::npos) {
+                        if (data.size() - pos > MAX_HEADER_BYTES) return fail("part headers too large");
+                        goto done;
+                    }
+                    if (!parse_part_headers(data.substr(pos, end - pos))) return false;
+                    pos = end + HEADER_END.size();
+                }
+                if (callbacks.on_part_begin && !callbacks.on_part_begin(part)) return fail("aborted by receiver");
+                state = State::BODY;
+                break;
+            }
+
+            case State::BODY: {
+                size_t found = find_delimiter(data.substr(pos));
+                if (found == std::string_view::npos) {
+                    // Everything except a possible delimiter prefix at the end is payload
+                    size_t safe = data.size() - pos;
+                    safe = safe >= delimiter.size() ? safe - (delimiter.size() - 1) : 0;
+                    if (safe > 0) {
+                        if (callbacks.on_part_data && !callbacks.on_part_data(data.substr(pos, safe))) {
+                            return fail("aborted by receiver");
+                        }
+                        pos += safe;
+                    }
+                    goto done;
+                }
+                if (found > 0 && callbacks.on_part_data && !callbacks.on_part_data(data.substr(pos, found))) {
+                    return fail("aborted by receiver");
+                }
+                if (callbacks.on_part_end) callbacks.on_part_end();
+                pos += found + delimiter.size();
+                state = State::AFTER_BOUNDARY;
+                break;
+            }
+
+            case State::DONE:
+            case State::FAILED:
+                goto done;
+        }
+    }
+
+done:
+    pending.erase(0, pos);
+    return true;
+}
+
+// ==========================================
+// FORM READER
+// ==========================================
+
+MultipartFormReader::MultipartFormReader(std::string_view boundary, RequestInfo& req)
+    : req(req),
+      parser(boundary, MultipartParser::Callbacks{
+                           [this](const MultipartPartInfo& info) { return begin_part(info); },
+                           [this](std::string_view data) { return part_data(data); },
+                           [this]() { end_part(); }}) {}
+
+MultipartFormReader::~MultipartFormReader() {
+    if (file_fd >= 0) close(file_fd);
+}
+
+bool MultipartFormReader::begin_part(const MultipartPartInfo& info) {
+    current = info;
+    field_value.clear();
+    if (!current.is_file()) return true;
+
+    const char* dir = std::getenv("UPLOAD_TMP_DIR");
+    std::string path = std::string(dir && *dir ? dir : "/tmp") + "/upload-XXXXXX";
+    file_fd = mkstemp(path.data());
+    if (file_fd < 0) return false;
+
+    UploadedFile upload;
+    upload.field = current.name;
+    upload.filename = current.filename;
+    upload.content_type = current.content_type;
+    upload.temp_path = std::move(path);
+    req.uploads.push_back(std::move(upload));
+    current_upload = &req.uploads.back();
+    return true;
+}
+
+bool MultipartFormReader::part_data(std::string_view data) {
+    if (!current_upload) {
+        // Plain fields are buffered, but their total is held to the regular payload limit
+        field_bytes += data.size();
+        if (field_bytes > MAX_PAYLOAD_SIZE) return false;
+        field_value.append(data);
+        return true;
+    }
+
+    while (!data.empty()) {
+        ssize_t written = write(file_fd, data.data(), data.size());
+        if (written < 0 && errno == EINTR) continue;
+        if (written <= 0) return false;
+        data.remove_prefix(static_cast<size_t>(written));
+        current_upload->size += static_cast<size_t>(written);
+    }
+    return true;
+}
+
+void MultipartFormReader::end_part() {
+    if (current_upload) {
+        close(file_fd);
+        file_fd = -1;
+        current_upload = nullptr;
+    } else {
+        req.params.set(current.name, field_value);
+    }
+}
@@ -0,0 +1,102 @@
+#include "../include/NotificationListener.hpp"
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <pqxx/pqxx>
+
+namespace {
+    // Bounds how long stop() waits for a listener blocked on its socket
+    constexpr long WAIT_SECONDS = 1;
+
+    class Receiver : public pqxx::notification_receiver {
+    public:
+        Receiver(pqxx::connection& conn, const std::string& channel) : pqxx::notification_receiver(conn, channel) {}
+
+        // Collected while libpq drains the socket, then handed over as one batch
+        void operator()(const std::string& payload, int) override { pending.push_back(payload); }
+
+        std::vector<std::string> pending;
+    };
+}
+
+NotificationListener::NotificationListener(Options options, Handler on_notify, std::function<void()> on_listen)
+    : options(std::move(options)), on_notify(std::move(on_notify)), on_listen(std::move(on_listen)) {}
+
+NotificationListener::~NotificationListener() {
+    stop();
+}
+
+void NotificationListener::start() {
+    if (running.exchange(true)) return;
+    thread = std::thread([this] { run(); });
+}
+
+void NotificationListener::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running.store(false);
+    }
+    wake.notify_all();
+    if (thread.joinable()) thread.join();
+}
+
+void NotificationListener::run() {
+    std::chrono::milliseconds backoff{0};
+    while (running.load()) {
+        try {
+            pqxx::connection conn(options.url);
+            Receiver receiver(conn, options.channel);
+
+            // LISTEN is in effect from here on; anything committed earlier is the caller's to fetch
+            active.store(true, std::memory_order_relaxed);
+            backoff = std::chrono::milliseconds(0);
+            resync_requested.store(false, std::memory_order_relaxed);
+            std::cout << "[DATABASE] Listening for notifications on " << options.channel << std::endl;
+            if (on_listen) on_listen();
+
+            while (running.load()) {
+                conn.await_notification(WAIT_SECONDS, 0);
+                if (receiver.pending.empty()) continue;
+                dispatch(receiver.pending);
+                receiver.pending.clear();
+                if (resync_requested.load(std::memory_order_relaxed)) {
+                    std::cerr << "[DATABASE] Reconnecting the listener on " << options.channel << " to catch up"
+                              << std::endl;
+                    break;
+                }
+            }
+        } catch (const std::exception& e) {
+            std::string error = e.what();
+            while (!error.empty() && error.back() == '\n') error.pop_back();
+            std::cerr << "[DB ERROR] Notification listener on " << options.channel << " lost its connection: "
+                      << error << std::endl;
+        }
+        active.store(false, std::memory_order_relaxed);
+        if (!running.load()) break;
+
+        reconnects.fetch_add(1, std::memory_order_relaxed);
+        backoff = std::clamp(backoff * 2, options.backoff_initial, options.backoff_max);
+        std::unique_lock<std::mutex> lock(mutex);
+        wake.wait_for(lock, backoff, [this] { return !running.load(); });
+    }
+}
+
+void NotificationListener::dispatch(const std::vector<std::string>& payloads) {
+    received.fetch_add(payloads.size(), std::memory_order_relaxed);
+    try {
+        on_notify(payloads);
+    } catch (const std::exception& e) {
+        // A failing handler must not cost the session (and with it every notification after it)
+        failed.fetch_add(payloads.size(), std::memory_order_relaxed);
+        std::cerr << "[ERROR] Notification on " << options.channel << " not handled: " << e.what() << std::endl;
+    }
+}
+
+std::string NotificationListener::to_prometheus() const {
+    std::ostringstream out;
+    out << "db_listener_connected " << (listening() ? 1 : 0) << "\n";
+    out << "db_listener_notifications_total " << received.load(std::memory_order_relaxed) << "\n";
+    out << "db_listener_notifications_failed_total " << failed.load(std::memory_order_relaxed) << "\n";
+    out << "db_listener_reconnects_total " << reconnects.load(std::memory_order_relaxed) << "\n";
+    return out.str();
+}
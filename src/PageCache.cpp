@@ -0,0 +1,34 @@
+#include "../include/PageCache.hpp"
+#include "../include/Compression.hpp"
+
+std::shared_ptr<const RenderedPage> PageCache::load() const {
+    std::lock_guard<std::mutex> lock(swap_mutex);
+    return current;
+}
+
+std::shared_ptr<const RenderedPage> PageCache::get(uint64_t version, const Renderer& render) {
+    std::shared_ptr<const RenderedPage> page = load();
+    if (page && page->version >= version) return page;
+
+    // Whoever gets here first renders; the rest find its result on the second check
+    std::lock_guard<std::mutex> build_lock(build_mutex);
+    page = load();
+    if (page && page->version >= version) return page;
+
+    auto next = std::make_shared<RenderedPage>();
+    next->version = version;
+    next->body = render();
+
+    // Compressed once per version instead of once per response
+    Deflater* deflater = Deflater::acquire(ContentCoding::GZIP);
+    bool ok = deflater->compress(next->body, next->gzip, Z_FINISH);
+    Deflater::release(deflater);
+    if (!ok || next->gzip.size() >= next->body.size()) next->gzip.clear();
+
+    page = std::move(next);
+    {
+        std::lock_guard<std::mutex> swap_lock(swap_mutex);
+        current = page;
+    }
+    return page;
+}
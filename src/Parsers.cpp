@@ -1,136 +1,243 @@
 #include "../include/Parsers.hpp"
-#include <sstream>
+#include "../include/Json.hpp"
+#include <algorithm>
+#include <array>
+#include <cstring>
 #include <unordered_map>
 #include <cctype>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 namespace {
     // Kept in an anonymous namespace to restrict linkage to this file only.
     bool ci_char_compare(char a, char b) {
         return std::tolower(static_cast<unsigned char>(a)) ==
                std::tolower(static_cast<unsigned char>(b));
     }
-}
 
-RequestInfo parse_url(const std::string& url) {
-    RequestInfo info;
+    // Maps every byte to its hex digit value, or 0xFF if it is not a hex digit.
+    constexpr std::array<uint8_t, 256> HEX_TABLE = [] {
+        std::array<uint8_t, 256> table{};
+        for (auto& v : table) v = 0xFF;
+        for (int i = 0; i < 10; ++i) table['0' + i] = static_cast<uint8_t>(i);
+        for (int i = 0; i < 6; ++i) {
+            table['a' + i] = static_cast<uint8_t>(10 + i);
+            table['A' + i] = static_cast<uint8_t>(10 + i);
+        }
+        return table;
+    }();
 
-    // 1. Separate Path from Query
-    size_t pos = url.find('?');
-    if (pos == std::string::npos) {
-        info.path = url;
-        info.query = "";
-    } else {
-        info.path = url.substr(0, pos);
-        info.query = url.substr(pos + 1);
+    constexpr size_t SIMD_BLOCK = 16;
+
+#if defined(__SSE2__) || defined(__ARM_NEON)
+    constexpr bool HAS_SIMD = true;
+#else
+    constexpr bool HAS_SIMD = false;
+#endif
+
+    // Translates the leading bytes of a full 16-byte block up to the first '%', turning '+' into
+    // ' ' on the way. Returns how many bytes were written to out (SIMD_BLOCK if no '%' was seen).
+    // The block is loaded before anything is stored, so out may trail in for in-place decoding.
+    inline size_t decode_block(const char* in, char* out) {
+#if defined(__SSE2__)
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+        __m128i plus = _mm_cmpeq_epi8(block, _mm_set1_epi8('+'));
+        __m128i translated = _mm_or_si128(_mm_andnot_si128(plus, block), _mm_and_si128(plus, _mm_set1_epi8(' ')));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, _mm_set1_epi8('%'))));
+        if (mask == 0) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out), translated);
+            return SIMD_BLOCK;
+        }
+        alignas(16) char staged[SIMD_BLOCK];
+        _mm_store_si128(reinterpret_cast<__m128i*>(staged), translated);
+        size_t plain = static_cast<size_t>(__builtin_ctz(mask));
+        std::memmove(out, staged, plain);
+        return plain;
+#elif defined(__ARM_NEON)
+        uint8x16_t block = vld1q_u8(reinterpret_cast<const uint8_t*>(in));
+        uint8x16_t translated = vbslq_u8(vceqq_u8(block, vdupq_n_u8('+')), vdupq_n_u8(' '), block);
+        uint8_t staged[SIMD_BLOCK];
+        vst1q_u8(staged, translated);
+        size_t plain = 0;
+        if (vmaxvq_u8(vceqq_u8(block, vdupq_n_u8('%'))) != 0) {
+            while (in[plain] != '%') ++plain;
+        } else {
+            plain = SIMD_BLOCK;
+        }
+        std::memmove(out, staged, plain);
+        return plain;
+#else
+        (void)in;
+        (void)out;
+        return 0;
+#endif
     }
+}
 
-    // 2. Normalize Path mapping root to index.html
-    if (info.path == "/") info.path = "/index.html";
-    if (!info.path.empty() && info.path[0] == '/') {
-        info.path.erase(0, 1);
+size_t url_decode_into(std::string_view src, char* dst) {
+    const char* in = src.data();
+    const char* end = in + src.size();
+    char* out = dst;
+
+    while (in < end) {
+        // 1. Fast path: translate whole 16-byte blocks until one contains an escape
+        if (HAS_SIMD && end - in >= static_cast<std::ptrdiff_t>(SIMD_BLOCK)) {
+            size_t plain = decode_block(in, out);
+            in += plain;
+            out += plain;
+            if (plain == SIMD_BLOCK) continue;
+        }
+
+        // 2. Slow path: one byte at a time until the next escape (or the end) is handled.
+        // Consecutive escapes, as in percent-encoded UTF-8, stay in this tight loop.
+        while (in < end) {
+            char c = *in;
+            if (c == '%') {
+                if (end - in >= 3) {
+                    uint8_t hi = HEX_TABLE[static_cast<uint8_t>(in[1])];
+                    uint8_t lo = HEX_TABLE[static_cast<uint8_t>(in[2])];
+                    if ((hi | lo) < 16) {
+                        *out++ = static_cast<char>((hi << 4) | lo);
+                        in += 3;
+                        if (in < end && *in == '%') continue;
+                        break;
+                    }
+                }
+                *out++ = c; // Malformed escape: keep it verbatim
+                ++in;
+            } else {
+                *out++ = (c == '+') ? ' ' : c;
+                ++in;
+                if (HAS_SIMD && end - in >= static_cast<std::ptrdiff_t>(SIMD_BLOCK)) break;
+            }
+        }
     }
 
-    // 3. Parse Query Parameters into the Map
-    std::stringstream ss(info.query);
-    std::string segment;
-    while (std::getline(ss, segment, '&')) {
-        size_t eqPos = segment.find('=');
-        if (eqPos != std::string::npos) {
-            std::string key = segment.substr(0, eqPos);
-            std::string value = segment.substr(eqPos + 1);
-            info.params[key] = value;
+    return static_cast<size_t>(out - dst);
+}
+
+namespace {
+    // Splits "k=v&k2=v2" in a single pass and decodes each pair straight into the store's arena.
+    // Segments without '=' are skipped.
+    void parse_urlencoded(std::string_view data, ParamStore& params) {
+        params.reserve(data.size());
+        while (!data.empty()) {
+            size_t amp = data.find('&');
+            std::string_view pair = data.substr(0, amp);
+            data.remove_prefix(amp == std::string_view::npos ? data.size() : amp + 1);
+
+            size_t eq = pair.find('=');
+            if (eq == std::string_view::npos) continue;
+            params.set_decoded(pair.substr(0, eq), pair.substr(eq + 1), url_decode_into);
         }
     }
+}
+
+RequestInfo parse_url(std::string_view url) {
+    RequestInfo info;
+
+    // 1. Separate Path from Query without copying either
+    size_t pos = url.find('?');
+    std::string_view path = url.substr(0, pos);
+    std::string_view query = (pos == std::string_view::npos) ? std::string_view{} : url.substr(pos + 1);
+
+    // 2. Normalize Path mapping root to index.html
+    if (path == "/") path = "/index.html";
+    if (!path.empty() && path.front() == '/') path.remove_prefix(1);
+
+    info.path = path;
+    info.query = query;
+
+    // 3. Tokenize and decode Query Parameters into the flat store
+    parse_urlencoded(query, info.params);
     return info;
 }
 
-std::string url_decode(const std::string& str) {
-    std::string decoded;
-    decoded.reserve(str.length()); // Pre-allocate memory to optimize concatenation
-
-    for (size_t i = 0; i < str.length(); ++i) {
-        if (str[i] == '+') {
-            decoded += ' ';
-        } else if (str[i] == '%' && i + 2 < str.length()) {
-            std::string hex = str.substr(i + 1, 2);
-            char c = static_cast<char>(std::stoul(hex, nullptr, 16));
-            decoded += c;
-            i += 2;
-        } else {
-            decoded += str[i];
-        }
+HttpMethod parse_method(std::string_view method) {
+    // Switch on length first so each token costs at most one comparison
+    switch (method.size()) {
+        case 3:
+            if (method == "GET") return HttpMethod::GET;
+            if (method == "PUT") return HttpMethod::PUT;
+            break;
+        case 4:
+            if (method == "POST") return HttpMethod::POST;
+            if (method == "HEAD") return HttpMethod::HEAD;
+            break;
+        case 5:
+            if (method == "PATCH") return HttpMethod::PATCH;
+            break;
+        case 6:
+            if (method == "DELETE") return HttpMethod::DELETE;
+            break;
+        case 7:
+            if (method == "OPTIONS") return HttpMethod::OPTIONS;
+            break;
+        default:
+            break;
     }
+    return HttpMethod::UNKNOWN;
+}
+
+std::string url_decode(std::string_view str) {
+    std::string decoded(str.size(), '\0');
+    decoded.resize(url_decode_into(str, decoded.data()));
     return decoded;
 }
 
 void parse_form_body(const std::string& form_body, RequestInfo& info) {
-    std::stringstream ss(form_body);
-    std::string segment;
-
-    while (std::getline(ss, segment, '&')) {
-        size_t eqPos = segment.find('=');
-        if (eqPos != std::string::npos) {
-            std::string key = url_decode(segment.substr(0, eqPos));
-            std::string value = url_decode(segment.substr(eqPos + 1));
-            info.params[key] = value;
-        }
-    }
+    parse_urlencoded(form_body, info.params);
 }
 
-void parse_json_body(const std::string& body, RequestInfo& info) {
-    enum State { SEARCHING, KEY, VALUE };
-    State state = SEARCHING;
-
-    std::string currentKey, currentValue;
-
-    for (size_t i = 0; i < body.length(); ++i) {
-        char c = body[i];
-
-        switch (state) {
-            case SEARCHING:
-                if (c == '"') state = KEY;
-                break;
-
-            case KEY:
-                if (c == '"') state = VALUE;
-                else currentKey += c;
-                break;
-
-            case VALUE:
-                // Ignore leading colons and whitespace
-                if (c == ':' || std::isspace(static_cast<unsigned char>(c))) continue;
-
-                // End of value pair
-                if (c == ',' || c == '}') {
-                    if (!currentKey.empty()) {
-                        info.params[currentKey] = currentValue;
-                        currentKey.clear();
-                        currentValue.clear();
-                    }
-                    state = SEARCHING;
-                }
-                // Handle string values and escaped quotes
-                else if (c == '"') {
-                    i++;
-                    while (i < body.length()) {
-                        if (body[i] == '\\' && i + 1 < body.length() && body[i+1] == '"') {
-                            currentValue += '"';
-                            i += 2;
-                        } else if (body[i] == '"') {
-                            break;
-                        } else {
-                            currentValue += body[i++];
-                        }
-                    }
-                }
-                else {
-                    currentValue += c; // Numeric or boolean values
+namespace {
+    // Flattening is a convenience for small bodies; bigger documents are read through info.json
+    constexpr size_t MAX_FLATTENED_PARAMS = 1000;
+    constexpr size_t MAX_FLATTENED_DEPTH = 32;
+
+    // Appends the scalars under value to params, keyed by their dotted path from the root, while budget lasts.
+    void flatten_json(const JsonValue& value, std::string& path, size_t depth, size_t& budget, ParamStore& params) {
+        if (value.is_object() || value.is_array()) {
+            if (depth == MAX_FLATTENED_DEPTH) return;
+            size_t base = path.size();
+            size_t position = 0;
+            for (auto it = value.begin(); it != value.end() && budget > 0; ++it, ++position) {
+                if (base > 0) path += '.';
+                if (value.is_object()) {
+                    path += it.key().as_string();
+                } else {
+                    path += std::to_string(position);
                 }
-                break;
+                flatten_json(it.value(), path, depth + 1, budget, params);
+                path.resize(base);
+            }
+            return;
+        }
+
+        if (!path.empty()) {
+            if (value.is_string()) {
+                params.set(path, value.as_string());
+            } else {
+                params.set(path, value.raw());
+            }
+            --budget;
         }
     }
 }
 
+void parse_json_body(const std::string& body, RequestInfo& info) {
+    auto doc = std::make_shared<JsonDocument>();
+    if (!doc->parse(body)) return;
+
+    std::string path;
+    size_t budget = MAX_FLATTENED_PARAMS;
+    flatten_json(doc->root(), path, 0, budget, info.params);
+    info.json = std::move(doc);
+}
+
 std::string get_mime_type(const std::string& path) {
     // Static map initialized once for O(1) lookups
     static const std::unordered_map<std::string, std::string> mime_types = {
@@ -0,0 +1,311 @@
+#include "../include/Pipeline.hpp"
+#include <algorithm>
+#include <charconv>
+#include <iostream>
+#include <sstream>
+
+using Clock = std::chrono::steady_clock;
+
+namespace {
+    std::string connection_error(PGconn* conn) {
+        std::string error = conn ? PQerrorMessage(conn) : "out of memory";
+        while (!error.empty() && error.back() == '\n') error.pop_back();
+        return error;
+    }
+}
+
+// ==========================================
+// RESULT
+// ==========================================
+
+bool PipelineResult::ok() const {
+    ExecStatusType status = PQresultStatus(result.get());
+    return status == PGRES_TUPLES_OK || status == PGRES_COMMAND_OK;
+}
+
+std::string_view PipelineResult::error() const {
+    if (PQresultStatus(result.get()) == PGRES_PIPELINE_ABORTED) {
+        return "skipped after an earlier statement in its transaction failed";
+    }
+    std::string_view message = PQresultErrorMessage(result.get());
+    while (!message.empty() && message.back() == '\n') message.remove_suffix(1);
+    return message;
+}
+
+std::string_view PipelineResult::sqlstate() const {
+    const char* state = PQresultErrorField(result.get(), PG_DIAG_SQLSTATE);
+    return state ? state : "";
+}
+
+size_t PipelineResult::size() const {
+    return static_cast<size_t>(std::max(PQntuples(result.get()), 0));
+}
+
+std::string_view PipelineResult::value(size_t row, int column) const {
+    int index = static_cast<int>(row);
+    return {PQgetvalue(result.get(), index, column), static_cast<size_t>(PQgetlength(result.get(), index, column))};
+}
+
+int64_t PipelineResult::as_int(size_t row, int column) const {
+    std::string_view text = value(row, column);
+    int64_t number = 0;
+    std::from_chars(text.data(), text.data() + text.size(), number);
+    return number;
+}
+
+// ==========================================
+// CONNECTION
+// ==========================================
+
+PipelineConnection::PipelineConnection(const std::string& url) : conn(PQconnectdb(url.c_str())) {
+    if (PQstatus(conn) != CONNECTION_OK || PQsetnonblocking(conn, 1) != 0 || PQenterPipelineMode(conn) != 1) {
+        std::string error = connection_error(conn);
+        PQfinish(conn);
+        throw PipelineError("Could not open a pipelined connection: " + error);
+    }
+}
+
+PipelineConnection::~PipelineConnection() {
+    PQfinish(conn);
+}
+
+bool PipelineConnection::is_open() const {
+    return !broken && PQstatus(conn) == CONNECTION_OK;
+}
+
+size_t PipelineConnection::prepare(const StatementRegistry& registry, size_t from) {
+    std::vector<PreparedStatement> pending = registry.since(from);
+    if (pending.empty()) return from;
+
+    QueryPipeline pipeline(*this);
+    for (const PreparedStatement& statement : pending) pipeline.prepare(statement.name, statement.sql);
+    std::vector<PipelineResult> results = pipeline.run();
+    for (size_t i = 0; i < results.size(); ++i) {
+        if (!results[i].ok()) {
+            throw PipelineError("Could not prepare '" + pending[i].name + "': " + std::string(results[i].error()));
+        }
+    }
+    return from + pending.size();
+}
+
+// ==========================================
+// PIPELINE
+// ==========================================
+
+QueryPipeline::~QueryPipeline() {
+    if (statements == 0) return;
+    try {
+        run();
+    } catch (const std::exception&) {
+        // run() marked the connection broken; the pool drops it
+    }
+}
+
+size_t QueryPipeline::prepare(const std::string& name, const std::string& sql) {
+    return queued(PQsendPrepare(conn.conn, name.c_str(), sql.c_str(), 0, nullptr));
+}
+
+size_t QueryPipeline::send(const std::string& command, const std::vector<std::string>& params, bool prepared) {
+    // Text-format parameters are C strings; a NUL inside one ends it early
+    std::vector<const char*> values;
+    values.reserve(params.size());
+    for (const std::string& param : params) values.push_back(param.c_str());
+    int count = static_cast<int>(values.size());
+
+    int sent = prepared
+        ? PQsendQueryPrepared(conn.conn, command.c_str(), count, values.data(), nullptr, nullptr, 0)
+        : PQsendQueryParams(conn.conn, command.c_str(), count, nullptr, values.data(), nullptr, nullptr, 0);
+    return queued(sent);
+}
+
+size_t QueryPipeline::queued(int sent) {
+    if (!sent) fail("Could not queue a statement");
+    steps.push_back(Step::STATEMENT);
+    return statements++;
+}
+
+void QueryPipeline::sync() {
+    if (steps.empty() || steps.back() == Step::SYNC) return;
+    if (!PQpipelineSync(conn.conn)) fail("Could not end a pipeline segment");
+    steps.push_back(Step::SYNC);
+}
+
+std::vector<PipelineResult> QueryPipeline::run() {
+    std::vector<PipelineResult> results;
+    if (statements == 0) {
+        steps.clear();
+        return results;
+    }
+    sync();
+    results.reserve(statements);
+
+    // Results come back in the order the commands went out: each statement's result followed by
+    // a null, and one PGRES_PIPELINE_SYNC per sync point. PQgetResult() flushes what is left of
+    // the queue while it waits, so the whole batch costs a single round trip.
+    for (Step step : steps) {
+        PGresult* result = PQgetResult(conn.conn);
+        if (!result) fail("Pipeline ended early");
+
+        if (step == Step::SYNC) {
+            ExecStatusType status = PQresultStatus(result);
+            PQclear(result);
+            if (status != PGRES_PIPELINE_SYNC) fail("Pipeline out of step");
+            continue;
+        }
+
+        results.push_back(PipelineResult(result));
+        if (PQstatus(conn.conn) != CONNECTION_OK) fail("Pipelined connection lost");
+        if (PGresult* extra = PQgetResult(conn.conn)) {
+            // One result per statement; COPY and multi-statement strings do not belong here
+            PQclear(extra);
+            fail("Pipelined statement returned more than one result");
+        }
+    }
+    steps.clear();
+    statements = 0;
+
+    if (conn.metrics) {
+        size_t failed = static_cast<size_t>(std::count_if(results.begin(), results.end(),
+                                                          [](const PipelineResult& r) { return !r.ok(); }));
+        conn.metrics->round_trips.fetch_add(1, std::memory_order_relaxed);
+        conn.metrics->statements.fetch_add(results.size(), std::memory_order_relaxed);
+        conn.metrics->failed_statements.fetch_add(failed, std::memory_order_relaxed);
+    }
+    return results;
+}
+
+void QueryPipeline::fail(const std::string& what) {
+    conn.broken = true;
+    steps.clear();
+    statements = 0;
+    throw PipelineError(what + ": " + connection_error(conn.conn));
+}
+
+// ==========================================
+// POOL
+// ==========================================
+
+PipelinePool::Lease::~Lease() {
+    if (pool) pool->give_back(std::move(slot));
+}
+
+PipelinePool::PipelinePool(Options options, StatementRegistry& registry)
+    : options(std::move(options)), registry(registry) {
+    idle.reserve(this->options.max_size);
+}
+
+PipelinePool::~PipelinePool() {
+    std::lock_guard<std::mutex> lock(mutex);
+    idle.clear();
+}
+
+PipelinePool::Lease PipelinePool::acquire() {
+    auto deadline = Clock::now() + options.checkout_timeout;
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        // 1. Reuse the warmest idle connection, pinging it first if it sat for a while
+        if (!idle.empty()) {
+            std::unique_ptr<PooledPipeline> slot = std::move(idle.back());
+            idle.pop_back();
+            bool stale = Clock::now() - slot->idle_since > options.idle_check;
+            lock.unlock();
+
+            if (!stale || healthy(*slot->conn)) return hand_out(std::move(slot));
+
+            slot.reset();
+            lock.lock();
+            --open_count;
+            continue;
+        }
+
+        // 2. Grow the pool, unless a recent failure put connecting on hold
+        auto now = Clock::now();
+        if (open_count < options.max_size && now >= next_connect_at) {
+            ++open_count;
+            lock.unlock();
+            try {
+                auto slot = std::make_unique<PooledPipeline>();
+                slot->conn = std::make_unique<PipelineConnection>(options.url);
+                slot->conn->metrics = &stats;
+                lock.lock();
+                backoff = std::chrono::milliseconds(0);
+                lock.unlock();
+                return hand_out(std::move(slot));
+            } catch (const std::exception& e) {
+                connect_failures.fetch_add(1, std::memory_order_relaxed);
+                lock.lock();
+                --open_count;
+                backoff = std::clamp(backoff * 2, options.backoff_initial, options.backoff_max);
+                next_connect_at = Clock::now() + backoff;
+                last_error = e.what();
+                std::cerr << "[DATABASE] Pipeline connect failed, backing off " << backoff.count() << "ms: "
+                          << last_error << std::endl;
+                available.notify_all();
+                continue;
+            }
+        }
+
+        // 3. Wait for a lease to come back, or for the backoff to expire
+        if (now >= deadline) break;
+        auto wake = deadline;
+        if (open_count < options.max_size) wake = std::min(wake, next_connect_at);
+        available.wait_until(lock, wake);
+    }
+
+    std::string reason = last_error.empty() ? "all connections busy" : "last connect error: " + last_error;
+    throw PoolTimeout("No pipelined connection available within " +
+                      std::to_string(options.checkout_timeout.count()) + "ms (" + reason + ")");
+}
+
+bool PipelinePool::healthy(PipelineConnection& conn) {
+    if (!conn.is_open()) return false;
+    try {
+        QueryPipeline ping(conn);
+        ping.exec_params("SELECT 1");
+        return ping.run().front().ok();
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+PipelinePool::Lease PipelinePool::hand_out(std::unique_ptr<PooledPipeline> slot) {
+    // Wrap first, so a failing prepare still returns the connection through the lease
+    Lease lease(this, std::move(slot));
+    PooledPipeline& entry = *lease.slot;
+    if (entry.prepared < registry.size()) entry.prepared = entry.conn->prepare(registry, entry.prepared);
+    return lease;
+}
+
+void PipelinePool::give_back(std::unique_ptr<PooledPipeline> slot) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        // A connection that broke while leased is not worth keeping
+        if (slot && slot->conn->is_open()) {
+            slot->idle_since = Clock::now();
+            idle.push_back(std::move(slot));
+        } else {
+            --open_count;
+        }
+    }
+    available.notify_one();
+}
+
+std::string PipelinePool::to_prometheus() const {
+    size_t open;
+    size_t idle_now;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        open = open_count;
+        idle_now = idle.size();
+    }
+
+    std::ostringstream out;
+    out << "db_pipeline_connections_open " << open << "\n";
+    out << "db_pipeline_connections_idle " << idle_now << "\n";
+    out << "db_pipeline_connect_failures_total " << connect_failures.load(std::memory_order_relaxed) << "\n";
+    out << "db_pipeline_round_trips_total " << stats.round_trips.load(std::memory_order_relaxed) << "\n";
+    out << "db_pipeline_statements_total " << stats.statements.load(std::memory_order_relaxed) << "\n";
+    out << "db_pipeline_failed_statements_total " << stats.failed_statements.load(std::memory_order_relaxed) << "\n";
+    return out.str();
+}
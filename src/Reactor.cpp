@@ -0,0 +1,150 @@
+#include "../include/Reactor.hpp"
+#include <cerrno>
+#include <iostream>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace {
+    constexpr int MAX_EVENTS = 64;                   ///< Events handled per epoll_wait call.
+}
+
+Reactor::Reactor() {
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epoll_fd < 0 || wake_fd < 0) {
+        std::cerr << "[ERROR] Could not create the event loop." << std::endl;
+        return;
+    }
+
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = wake_fd;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wake_fd, &event);
+}
+
+Reactor::~Reactor() {
+    stop();
+    if (wake_fd >= 0) close(wake_fd);
+    if (epoll_fd >= 0) close(epoll_fd);
+}
+
+void Reactor::start() {
+    if (running.exchange(true)) return;
+    loop = std::thread(&Reactor::run, this);
+}
+
+void Reactor::stop() {
+    if (!running.exchange(false)) return;
+    uint64_t one = 1;
+    [[maybe_unused]] ssize_t ignored = write(wake_fd, &one, sizeof(one));
+    if (loop.joinable()) loop.join();
+}
+
+void Reactor::post(Task task) {
+    bool was_empty;
+    {
+        std::lock_guard<std::mutex> lock(task_mutex);
+        was_empty = tasks.empty();
+        tasks.push_back(std::move(task));
+    }
+    // One wake-up per batch of tasks is enough; the loop drains them all
+    if (was_empty) {
+        uint64_t one = 1;
+        [[maybe_unused]] ssize_t ignored = write(wake_fd, &one, sizeof(one));
+    }
+}
+
+void Reactor::watch(int fd, uint32_t events, EventHandler handler) {
+    epoll_event event{};
+    event.events = events;
+    event.data.fd = fd;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) < 0) {
+        std::cerr << "[ERROR] Could not watch descriptor " << fd << std::endl;
+        return;
+    }
+    handlers[fd] = std::make_shared<EventHandler>(std::move(handler));
+    watch_count.store(handlers.size(), std::memory_order_relaxed);
+}
+
+void Reactor::modify(int fd, uint32_t events) {
+    epoll_event event{};
+    event.events = events;
+    event.data.fd = fd;
+    epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &event);
+}
+
+void Reactor::unwatch(int fd) {
+    if (handlers.erase(fd) == 0) return;
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+    watch_count.store(handlers.size(), std::memory_order_relaxed);
+}
+
+uint64_t Reactor::add_timer(Clock::time_point when, Task task) {
+    uint64_t id = next_timer_id++;
+    timers.emplace(std::make_pair(when, id), std::move(task));
+    timer_deadlines.emplace(id, when);
+    return id;
+}
+
+void Reactor::cancel_timer(uint64_t id) {
+    auto it = timer_deadlines.find(id);
+    if (it == timer_deadlines.end()) return;
+    timers.erase({it->second, id});
+    timer_deadlines.erase(it);
+}
+
+int Reactor::next_timeout_ms() const {
+    if (timers.empty()) return -1;
+    auto wait = timers.begin()->first.first - Clock::now();
+    if (wait <= Clock::duration::zero()) return 0;
+    // Round up, so a timer never fires a little early and forces another pass
+    return static_cast<int>(std::chrono::ceil<std::chrono::milliseconds>(wait).count());
+}
+
+void Reactor::run() {
+    epoll_event events[MAX_EVENTS];
+    while (running.load(std::memory_order_relaxed)) {
+        int ready = epoll_wait(epoll_fd, events, MAX_EVENTS, next_timeout_ms());
+        if (ready < 0 && errno != EINTR) {
+            std::cerr << "[ERROR] Event loop failed." << std::endl;
+            break;
+        }
+
+        for (int i = 0; i < ready; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == wake_fd) {
+                uint64_t count;
+                [[maybe_unused]] ssize_t ignored = read(wake_fd, &count, sizeof(count));
+                continue;
+            }
+
+            // An earlier handler in this batch may already have unwatched it
+            auto it = handlers.find(fd);
+            if (it == handlers.end()) continue;
+            std::shared_ptr<EventHandler> handler = it->second;
+            (*handler)(events[i].events);
+        }
+
+        run_tasks();
+        run_timers();
+    }
+}
+
+void Reactor::run_tasks() {
+    std::vector<Task> batch;
+    {
+        std::lock_guard<std::mutex> lock(task_mutex);
+        batch.swap(tasks);
+    }
+    for (Task& task : batch) task();
+}
+
+void Reactor::run_timers() {
+    auto now = Clock::now();
+    while (!timers.empty() && timers.begin()->first.first <= now) {
+        auto node = timers.extract(timers.begin());
+        timer_deadlines.erase(node.key().second);
+        node.mapped()();
+    }
+}
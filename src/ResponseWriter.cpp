@@ -0,0 +1,111 @@
+#include "../include/ResponseWriter.hpp"
+#include "../include/Compression.hpp"
+#include <cerrno>
+#include <charconv>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+bool send_all(int socket, std::string_view data) {
+    while (!data.empty()) {
+        ssize_t sent = send(socket, data.data(), data.size(), 0);
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent <= 0) return false;
+        data.remove_prefix(static_cast<size_t>(sent));
+    }
+    return true;
+}
+
+ResponseWriter::~ResponseWriter() {
+    Deflater::release(deflater);
+}
+
+void ResponseWriter::set_compression(ContentCoding coding) {
+    if (deflater || coding == ContentCoding::IDENTITY || total > 0) return;
+    deflater = Deflater::acquire(coding);
+}
+
+bool ResponseWriter::write(std::string_view data) {
+    if (error || finished) return false;
+    total += data.size();
+
+    if (deflater) {
+        // zlib buffers internally; a chunk goes out once enough compressed output accumulates
+        if (!deflater->compress(data, buffer, Z_NO_FLUSH)) return fail();
+        if (buffer.size() < FLUSH_THRESHOLD) return true;
+        bool ok = send_chunk(buffer);
+        buffer.clear();
+        return ok;
+    }
+
+    // Large writes skip the buffer (after whatever is already queued, to keep the order)
+    if (buffer.size() + data.size() >= FLUSH_THRESHOLD) {
+        if (!flush()) return false;
+        if (data.size() >= FLUSH_THRESHOLD) return send_chunk(data);
+    }
+    buffer.append(data);
+    return true;
+}
+
+bool ResponseWriter::flush() {
+    if (error) return false;
+    if (deflater && !finished && !deflater->compress({}, buffer, Z_SYNC_FLUSH)) return fail();
+    if (buffer.empty()) return true;
+    bool ok = send_chunk(buffer);
+    buffer.clear();
+    return ok;
+}
+
+bool ResponseWriter::finish() {
+    if (finished) return !error;
+    if (deflater && !error && !deflater->compress({}, buffer, Z_FINISH)) return fail();
+    finished = true;
+    bool ok = flush() && send_all(socket, "0\r\n\r\n");
+    if (!ok) error = true;
+    return ok;
+}
+
+bool ResponseWriter::fail() {
+    error = true;
+    return false;
+}
+
+bool ResponseWriter::send_chunk(std::string_view data) {
+    // Size line, payload and trailing CRLF leave in a single system call
+    char size_line[20];
+    auto [end, ec] = std::to_chars(size_line, size_line + sizeof(size_line) - 2, data.size(), 16);
+    *end++ = '\r';
+    *end++ = '\n';
+
+    iovec parts[3] = {
+        {size_line, static_cast<size_t>(end - size_line)},
+        {const_cast<char*>(data.data()), data.size()},
+        {const_cast<char*>("\r\n"), 2}
+    };
+    iovec* current = parts;
+    int remaining = 3;
+
+    while (remaining > 0) {
+        msghdr message{};
+        message.msg_iov = current;
+        message.msg_iovlen = static_cast<size_t>(remaining);
+        ssize_t sent = sendmsg(socket, &message, 0);
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent <= 0) {
+            error = true;
+            return false;
+        }
+
+        // Skip fully sent parts and trim the partially sent one
+        auto left = static_cast<size_t>(sent);
+        while (remaining > 0 && left >= current->iov_len) {
+            left -= current->iov_len;
+            ++current;
+            --remaining;
+        }
+        if (remaining > 0) {
+            current->iov_base = static_cast<char*>(current->iov_base) + left;
+            current->iov_len -= left;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,196 @@
+#include "../include/Router.hpp"
+#include <stdexcept>
+
+struct Router::Node {
+    std::string prefix;                              ///< Compressed static edge label leading into this node.
+    std::string indices;                             ///< First byte of each static child, parallel to children.
+    std::vector<std::unique_ptr<Node>> children;     ///< Static children, at most one per first byte.
+    std::unique_ptr<Node> param_child;               ///< ":name" capture of a single segment.
+    std::unique_ptr<Node> wildcard_child;            ///< "*name" capture of the remaining path.
+    std::string capture_name;                        ///< Parameter name when this node is a capture.
+    std::array<RouteHandler, HTTP_METHOD_COUNT> handlers;
+    std::array<RouteOptions, HTTP_METHOD_COUNT> options;
+    uint16_t allowed_methods = 0;                    ///< Bitmask of filled handler slots.
+};
+
+namespace {
+    constexpr std::array<std::string_view, HTTP_METHOD_COUNT> METHOD_NAMES = {
+        "GET", "HEAD", "POST", "PUT", "PATCH", "DELETE", "OPTIONS", ""
+    };
+
+    constexpr uint16_t method_bit(HttpMethod method) {
+        return static_cast<uint16_t>(1u << static_cast<unsigned>(method));
+    }
+
+    std::string_view strip_leading_slash(std::string_view path) {
+        if (!path.empty() && path.front() == '/') path.remove_prefix(1);
+        return path;
+    }
+
+    size_t common_prefix(std::string_view a, std::string_view b) {
+        size_t n = std::min(a.size(), b.size());
+        size_t i = 0;
+        while (i < n && a[i] == b[i]) ++i;
+        return i;
+    }
+}
+
+Router::Router() : root(std::make_unique<Node>()) {}
+
+Router::~Router() = default;
+
+Router::Node* Router::insert(std::string_view pattern) {
+    pattern = strip_leading_slash(pattern);
+    Node* node = root.get();
+
+    while (!pattern.empty()) {
+        // 1. Captures occupy their own child slot rather than a static edge
+        if (pattern.front() == ':' || pattern.front() == '*') {
+            bool wildcard = pattern.front() == '*';
+            size_t end = wildcard ? pattern.size() : pattern.find('/');
+            if (end == std::string_view::npos) end = pattern.size();
+            std::string_view name = pattern.substr(1, end - 1);
+
+            if (name.empty()) {
+                throw std::invalid_argument("Router: unnamed capture in route pattern");
+            }
+
+            std::unique_ptr<Node>& slot = wildcard ? node->wildcard_child : node->param_child;
+            if (!slot) {
+                slot = std::make_unique<Node>();
+                slot->capture_name = name;
+            } else if (slot->capture_name != name) {
+                throw std::invalid_argument("Router: conflicting capture names '" + slot->capture_name +
+                                            "' and '" + std::string(name) + "'");
+            }
+
+            node = slot.get();
+            pattern.remove_prefix(end);
+            continue;
+        }
+
+        // 2. Static text runs until the next capture marker
+        size_t run_end = pattern.find_first_of(":*");
+        std::string_view run = pattern.substr(0, run_end);
+        pattern.remove_prefix(run.size());
+
+        while (!run.empty()) {
+            size_t idx = node->indices.find(run.front());
+            if (idx == std::string::npos) {
+                auto child = std::make_unique<Node>();
+                child->prefix = run;
+                node->indices.push_back(run.front());
+                node->children.push_back(std::move(child));
+                node = node->children.back().get();
+                break;
+            }
+
+            Node* child = node->children[idx].get();
+            size_t shared = common_prefix(child->prefix, run);
+
+            // Split the existing edge so that both routes share the common prefix
+            if (shared < child->prefix.size()) {
+                auto split = std::make_unique<Node>();
+                split->prefix = child->prefix.substr(0, shared);
+                child->prefix.erase(0, shared);
+                split->indices.push_back(child->prefix.front());
+                split->children.push_back(std::move(node->children[idx]));
+                node->children[idx] = std::move(split);
+                child = node->children[idx].get();
+            }
+
+            node = child;
+            run.remove_prefix(shared);
+        }
+    }
+
+    return node;
+}
+
+void Router::add(HttpMethod method, std::string_view pattern, const RouteHandler& handler, const RouteOptions& options) {
+    Node* node = insert(pattern);
+    node->handlers[static_cast<size_t>(method)] = handler;
+    node->options[static_cast<size_t>(method)] = options;
+    node->allowed_methods |= method_bit(method);
+}
+
+void Router::add_any(std::string_view pattern, const RouteHandler& handler) {
+    Node* node = insert(pattern);
+    for (size_t i = 0; i < HTTP_METHOD_COUNT; ++i) {
+        node->handlers[i] = handler;
+    }
+    node->allowed_methods = static_cast<uint16_t>((1u << HTTP_METHOD_COUNT) - 1);
+}
+
+namespace {
+    using Captures = std::vector<std::pair<std::string_view, std::string_view>>;
+
+    template <typename NodeT>
+    const NodeT* find_node(const NodeT* node, std::string_view rest, Captures& captures) {
+        if (rest.empty() && node->allowed_methods != 0) return node;
+
+        // 1. Static edges first: at most one child can share the next byte
+        if (!rest.empty()) {
+            size_t idx = node->indices.find(rest.front());
+            if (idx != std::string::npos) {
+                const NodeT* child = node->children[idx].get();
+                if (rest.starts_with(child->prefix)) {
+                    if (const NodeT* hit = find_node(child, rest.substr(child->prefix.size()), captures)) {
+                        return hit;
+                    }
+                }
+            }
+        }
+
+        // 2. Single-segment capture, backtracking if the subtree does not match
+        if (node->param_child && !rest.empty() && rest.front() != '/') {
+            size_t end = rest.find('/');
+            if (end == std::string_view::npos) end = rest.size();
+            captures.emplace_back(node->param_child->capture_name, rest.substr(0, end));
+            if (const NodeT* hit = find_node(node->param_child.get(), rest.substr(end), captures)) {
+                return hit;
+            }
+            captures.pop_back();
+        }
+
+        // 3. Catch-all swallows whatever is left, including an empty remainder
+        if (node->wildcard_child && node->wildcard_child->allowed_methods != 0) {
+            captures.emplace_back(node->wildcard_child->capture_name, rest);
+            return node->wildcard_child.get();
+        }
+
+        return nullptr;
+    }
+}
+
+RouteMatch Router::match(HttpMethod method, RequestInfo& req) const {
+    RouteMatch result;
+    req.path_params.clear();
+
+    const Node* node = find_node(root.get(), strip_leading_slash(req.path), req.path_params);
+    if (!node) return result;
+
+    result.allowed_methods = node->allowed_methods;
+    size_t slot = static_cast<size_t>(method);
+
+    if (node->allowed_methods & method_bit(method)) {
+        result.handler = &node->handlers[slot];
+        result.options = &node->options[slot];
+    } else if (method == HttpMethod::HEAD && (node->allowed_methods & method_bit(HttpMethod::GET))) {
+        // HEAD is answered by the GET handler when no dedicated one exists
+        result.handler = &node->handlers[static_cast<size_t>(HttpMethod::GET)];
+        result.options = &node->options[static_cast<size_t>(HttpMethod::GET)];
+    }
+
+    return result;
+}
+
+std::string Router::format_allow(uint16_t allowed_methods) {
+    std::string allow;
+    for (size_t i = 0; i < HTTP_METHOD_COUNT; ++i) {
+        if (!(allowed_methods & (1u << i)) || METHOD_NAMES[i].empty()) continue;
+        if (!allow.empty()) allow += ", ";
+        allow += METHOD_NAMES[i];
+    }
+    return allow;
+}
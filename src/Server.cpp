@@ -1,11 +1,18 @@
 #include "../include/Server.hpp"
 #include "../include/Parsers.hpp"
+#include "../include/Multipart.hpp"
+#include "../include/BodyStream.hpp"
+#include "../include/ResponseWriter.hpp"
+#include <sys/epoll.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <unistd.h>
 #include <iostream>
 #include <fstream>
 #include <csignal>
+#include <optional>
+#include <strings.h>
+#include <charconv>
 
 // ==========================================
 // SERVER CONSTANTS & CONFIGURATION
@@ -13,17 +20,20 @@
 namespace ServerConstants {
 	constexpr int LISTEN_BACKLOG = 100;        ///< Maximum length of the queue of pending connections
 	constexpr int TIMEOUT_SECONDS = 5;         ///< Keep-Alive timeout to prevent thread starvation
-	constexpr size_t MAX_READ_BUFFER = 30000;  ///< Initial buffer size for incoming HTTP requests
-	constexpr size_t CHUNK_BUFFER_SIZE = 4096; ///< Buffer size for reading large payloads
+	constexpr size_t MAX_READ_BUFFER = 30000;  ///< Largest accepted header section of an HTTP request
+	constexpr size_t HEADER_READ_SIZE = 8192;  ///< Read size while waiting for a complete header section
+	constexpr size_t MAX_DRAIN_BYTES = 65536;  ///< Unread streamed body we still drain to keep the connection alive
 
 	const std::string HTTP_DELIM = "\r\n\r\n";
 	const std::string PUBLIC_DIR = "public/";
 	const std::string DEFAULT_INDEX = "index.html";
-	const std::string HDR_CONNECTION = "Connection:";
-	const std::string HDR_CONTENT_LEN = "Content-Length:";
-	const std::string HDR_CONTENT_TYPE = "Content-Type:";
+	const std::string HDR_CONNECTION = "Connection";
+	const std::string HDR_CONTENT_LEN = "Content-Length";
+	const std::string HDR_CONTENT_TYPE = "Content-Type";
+	const std::string HDR_TRANSFER_ENC = "Transfer-Encoding";
 	const std::string MIME_URLENCODED = "application/x-www-form-urlencoded";
 	const std::string MIME_JSON = "application/json";
+	const std::string MIME_MULTIPART = "multipart/form-data";
 }
 
 // Global logger mutex ensures console output isn't garbled by concurrent threads
@@ -43,6 +53,36 @@ void log_request( const RequestInfo &req, const Response &res )
 			<< res.status_code << " " << res.status_text << std::endl;
 }
 
+// Builds a plain-text error response for requests rejected before routing
+static Response error_response( int status_code, const std::string &status_text, const std::string &body )
+{
+	Response res;
+	res.status_code = status_code;
+	res.status_text = status_text;
+	res.content_type = "text/plain";
+	res.body = body;
+	return res;
+}
+
+// Case-insensitive comparison of a header value against a single token, ignoring surrounding spaces
+static bool iequals_token( std::string_view value, std::string_view token )
+{
+	while (!value.empty() && (value.front() == ' ' || value.front() == '\t'))
+		value.remove_prefix(1);
+	while (!value.empty() && (value.back() == ' ' || value.back() == '\t'))
+		value.remove_suffix(1);
+	return value.size() == token.size() && strncasecmp(value.data(), token.data(), token.size()) == 0;
+}
+
+// Parses a Content-Length value: digits only, no sign, no trailing text, no overflow
+static bool parse_content_length( std::string_view value, size_t &length )
+{
+	if (value.empty())
+		return false;
+	auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), length);
+	return ec == std::errc() && end == value.data() + value.size();
+}
+
 HttpServer::HttpServer( int port, int thread_count )
 	: port(port), server_fd(-1), thread_count(thread_count), stop_server(false)
 {
@@ -57,7 +97,13 @@ HttpServer::~HttpServer()
 
 void HttpServer::add_route( const std::string &path, const RouteHandler &handler )
 {
-	routes[path] = handler;
+	router.add_any(path, handler);
+}
+
+void HttpServer::add_route( HttpMethod method, const std::string &path, const RouteHandler &handler,
+                            const RouteOptions &options )
+{
+	router.add(method, path, handler, options);
 }
 
 void HttpServer::start()
@@ -90,11 +136,13 @@ void HttpServer::start()
 	listen(server_fd, ServerConstants::LISTEN_BACKLOG);
 	std::cout << "Server listening on port " << port << " with " << thread_count << " threads..." << std::endl;
 
-	// 5. Spin up the worker threads ("Consumers") which will block until tasks are added
+	// 5. Spin up the worker threads ("Consumers") which will block until tasks are added,
+	// and the event loop that holds connections waiting on a deferred response
 	for (int i = 0 ; i < thread_count ; ++i)
 	{
 		thread_pool.emplace_back(&HttpServer::worker_thread, this);
 	}
+	reactor.start();
 
 	// 6. The Main Accept Loop (Producer)
 	socklen_t addrlen = sizeof(address);
@@ -105,13 +153,8 @@ void HttpServer::start()
 
 		if (new_socket >= 0)
 		{
-			// Safely push the new client socket onto the task queue
-			{
-				std::lock_guard <std::mutex> lock(queue_mutex);
-				task_queue.push(new_socket);
-			}
-			// Wake up one sleeping worker thread to handle this connection
-			cv.notify_one();
+			// Safely push the new client socket onto the task queue and wake up one sleeping worker
+			enqueue({new_socket, nullptr});
 		}
 		else if (stop_server.load())
 		{
@@ -125,7 +168,7 @@ void HttpServer::worker_thread()
 {
 	while (true)
 	{
-		int client_socket; {
+		ClientTask task; {
 			std::unique_lock <std::mutex> lock(queue_mutex);
 			// Wait until there's a task or the server is shutting down
 			cv.wait(lock, [this]
@@ -138,36 +181,75 @@ void HttpServer::worker_thread()
 				return; // Exit thread cleanly
 			}
 
-			client_socket = task_queue.front();
+			task = std::move(task_queue.front());
 			task_queue.pop();
 		}
-		handle_client(client_socket);
+		handle_client(task.socket, std::move(task.resumed));
+	}
+}
+
+void HttpServer::enqueue( ClientTask task )
+{
+	{
+		std::lock_guard <std::mutex> lock(queue_mutex);
+		task_queue.push(std::move(task));
 	}
+	cv.notify_one();
 }
 
-void HttpServer::handle_client( int client_socket ) const
+void HttpServer::handle_client( int client_socket, std::shared_ptr<PendingResponse> resumed )
 {
 	// 1. Configure a strict timeout. If a client connects but sends nothing,
 	// we drop them after 5 seconds to prevent thread starvation.
 	struct timeval timeout{ServerConstants::TIMEOUT_SECONDS, 0};
 	setsockopt(client_socket, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast <const char *>(&timeout), sizeof(timeout));
 
-	// 2. The Keep-Alive Loop: Process requests until the connection should close
-	while (true)
+	// 2. The Keep-Alive Loop: Process requests until the connection should close.
+	// The buffer outlives each request so pipelined bytes that arrive with a body are not lost.
+	std::string connection_buffer;
+
+	// A connection coming back from the event loop first delivers its deferred answer
+	if (resumed)
 	{
-		char buffer[ServerConstants::MAX_READ_BUFFER] = {0};
-		long valread = read(client_socket, buffer, sizeof(buffer));
+		connection_buffer = std::move(resumed->buffer);
+		bool keep_alive = send_response(client_socket, resumed->req, resumed->answer);
+		resumed.reset();
+		if (!keep_alive)
+		{
+			close(client_socket);
+			return;
+		}
+	}
 
-		if (valread <= 0)
-			break; // Break loop if client disconnected or timed out
+	while (true)
+	{
+		// HTTP headers and body are separated by a double CRLF ("\r\n\r\n")
+		size_t body_pos = connection_buffer.find(ServerConstants::HTTP_DELIM);
+		bool client_gone = false;
+		while (body_pos == std::string::npos)
+		{
+			if (connection_buffer.size() >= ServerConstants::MAX_READ_BUFFER)
+				break; // Header section too large
 
-		std::string requestData(buffer, valread);
+			char buffer[ServerConstants::HEADER_READ_SIZE];
+			long valread = read(client_socket, buffer, sizeof(buffer));
+			if (valread <= 0)
+			{
+				client_gone = true; // Client disconnected or timed out
+				break;
+			}
 
-		// HTTP headers and body are separated by a double CRLF ("\r\n\r\n")
-		size_t body_pos = requestData.find(ServerConstants::HTTP_DELIM);
-		if (body_pos == std::string::npos)
+			size_t search_from = connection_buffer.size() < 3 ? 0 : connection_buffer.size() - 3;
+			connection_buffer.append(buffer, valread);
+			body_pos = connection_buffer.find(ServerConstants::HTTP_DELIM, search_from);
+		}
+		if (client_gone || body_pos == std::string::npos)
 			break; // Malformed request
 
+		// Split the header section off; what remains in the buffer is the body (and possibly the next request)
+		std::string requestData = connection_buffer.substr(0, body_pos + 4);
+		connection_buffer.erase(0, body_pos + 4);
+
 		// Extract the HTTP method (e.g., GET, POST) and the raw URI
 		size_t first_space = requestData.find(' ');
 		size_t second_space = requestData.find(' ', first_space + 1);
@@ -176,59 +258,118 @@ void HttpServer::handle_client( int client_socket ) const
 
 		RequestInfo req = parse_url(rawUrl);
 		req.method = method;
+		req.method_id = parse_method(method);
+		req.head = std::move(requestData);
 
 		// Determine if the client explicitly requested to close the connection
-		std::string conn_header = extract_header_value(requestData, body_pos, ServerConstants::HDR_CONNECTION);
+		std::string_view conn_header = req.header(ServerConstants::HDR_CONNECTION);
 		if (conn_header.find("close") != std::string::npos || conn_header.find("Close") != std::string::npos)
 		{
 			req.keep_alive = false;
 		}
 
-		// 3. Payload Handling: Read the request body if Content-Length is provided
-		std::string content_len_str = extract_header_value(requestData, body_pos, ServerConstants::HDR_CONTENT_LEN);
+		// Normalize path for static routing defaults
+		if (req.path.empty() || req.path == "/" || req.path == "public" || req.path == ServerConstants::PUBLIC_DIR)
+			req.path = ServerConstants::DEFAULT_INDEX;
+		if (req.path.size() >= ServerConstants::PUBLIC_DIR.size() && req.path.substr(
+			    0, ServerConstants::PUBLIC_DIR.size()) == ServerConstants::PUBLIC_DIR)
+			req.path = req.path.substr(ServerConstants::PUBLIC_DIR.size());
+
+		// Resolve the route first: its options decide how (and whether) the body is received
+		RouteMatch match = resolve(req);
+		bool stream_body = match.options && match.options->stream_body;
+
+		// 3. Payload Handling: The body is pulled from the socket on demand (see BodyStream)
+		std::string content_len_str(req.header(ServerConstants::HDR_CONTENT_LEN));
+		std::string contentType(req.header(ServerConstants::HDR_CONTENT_TYPE));
+		bool is_multipart = req.method_id == HttpMethod::POST &&
+		                    contentType.find(ServerConstants::MIME_MULTIPART) != std::string::npos;
+		std::string_view transfer_encoding = req.header(ServerConstants::HDR_TRANSFER_ENC);
+		size_t content_len_count = req.header_count(ServerConstants::HDR_CONTENT_LEN);
+		size_t transfer_enc_count = req.header_count(ServerConstants::HDR_TRANSFER_ENC);
+		bool is_chunked = transfer_enc_count > 0;
+		size_t content_length = 0;
+		bool bad_content_length = content_len_count > 1 ||
+		                          (content_len_count == 1 && !parse_content_length(content_len_str, content_length));
+		size_t body_limit = (match.options && match.options->max_body)
+			                    ? *match.options->max_body
+			                    : (is_multipart ? MAX_UPLOAD_SIZE : MAX_PAYLOAD_SIZE);
+
+		// A chunked body ends where its framing says, which is also where the next request starts
+		std::optional <BodyStream> body;
+		if (is_chunked)
+			body.emplace(client_socket, connection_buffer, BodyStream::Chunked{}, body_limit);
+		else
+			body.emplace(client_socket, connection_buffer, content_length);
+
 		Response res;
 		bool error_occurred = false;
 
-		if (!content_len_str.empty())
+		if (bad_content_length)
 		{
-			size_t content_length = std::stoull(content_len_str);
-
-			// Security constraint: Prevent memory exhaustion attacks
-			if (content_length > MAX_PAYLOAD_SIZE)
+			// A repeated or non-numeric length leaves the body's end open to interpretation
+			res = error_response(400, "Bad Request", "Invalid Content-Length.");
+			error_occurred = true;
+		}
+		else if (is_chunked && (content_len_count > 0 || transfer_enc_count > 1 ||
+		                        !iequals_token(transfer_encoding, "chunked")))
+		{
+			// Both framings at once is the classic request smuggling vector; other codings are unsupported
+			res = error_response(400, "Bad Request", "Unsupported Transfer-Encoding.");
+			error_occurred = true;
+		}
+		// Security constraint: Prevent memory exhaustion attacks. Rejected before a single body byte is read.
+		else if (content_length > body_limit)
+		{
+			res = error_response(413, "Payload Too Large", "Payload exceeds limits.");
+			error_occurred = true;
+		}
+		else if (stream_body)
+		{
+			// The handler pulls the body itself, at its own pace
+			req.body_stream = &*body;
+		}
+		else if (is_multipart)
+		{
+			// Stream the body through the multipart parser instead of buffering it
+			std::string boundary = MultipartParser::boundary_from_content_type(contentType);
+			MultipartFormReader reader(boundary, req);
+			bool ok = !boundary.empty();
+			for (std::string_view chunk = body->next() ; ok && !chunk.empty() ; chunk = body->next())
+				ok = reader.feed(chunk);
+
+			if (body->too_large())
 			{
-				res.status_code = 413;
-				res.status_text = "Payload Too Large";
-				res.content_type = "text/plain";
-				res.body = "Payload exceeds limits.";
+				res = error_response(413, "Payload Too Large", "Payload exceeds limits.");
 				error_occurred = true;
 			}
-			else
+			else if (!ok || !reader.finished())
 			{
-				// Read chunks from the socket until the full body is received
-				size_t current_body_len = requestData.length() - (body_pos + 4);
-				while (current_body_len < content_length)
-				{
-					char extra_buffer[ServerConstants::CHUNK_BUFFER_SIZE];
-					size_t to_read = std::min(static_cast <size_t>(ServerConstants::CHUNK_BUFFER_SIZE),
-					                          content_length - current_body_len);
-					long extra_read = read(client_socket, extra_buffer, to_read);
-					if (extra_read <= 0)
-						break;
-
-					requestData.append(extra_buffer, extra_read);
-					current_body_len += extra_read;
-				}
-				req.body = requestData.substr(body_pos + 4, content_length);
+				res = error_response(400, "Bad Request", "Malformed multipart body.");
+				error_occurred = true;
+			}
+		}
+		else if (!body->read_all(req.body))
+		{
+			if (body->too_large())
+			{
+				res = error_response(413, "Payload Too Large", "Payload exceeds limits.");
+				error_occurred = true;
 			}
+			else if (is_chunked)
+			{
+				res = error_response(400, "Bad Request", "Malformed chunked body.");
+				error_occurred = true;
+			}
+			req.keep_alive = false; // Client vanished mid-body; answer with what arrived
 		}
 
 		// 4. Request Routing & Execution
 		if (!error_occurred)
 		{
-			// Parse specific body types for POST requests
-			if (req.method == "POST")
+			// Parse specific body types for POST requests (multipart and streamed bodies are already handled)
+			if (req.method == "POST" && !stream_body)
 			{
-				std::string contentType = extract_header_value(requestData, body_pos, ServerConstants::HDR_CONTENT_TYPE);
 				if (contentType.find(ServerConstants::MIME_URLENCODED) != std::string::npos)
 				{
 					parse_form_body(req.body, req);
@@ -239,47 +380,33 @@ void HttpServer::handle_client( int client_socket ) const
 				}
 			}
 
-			// Normalize path for static routing defaults
-			if (req.path.empty() || req.path == "/" || req.path == "public" || req.path == ServerConstants::PUBLIC_DIR)
-				req.path = ServerConstants::DEFAULT_INDEX;
-			if (req.path.size() >= ServerConstants::PUBLIC_DIR.size() && req.path.substr(
-				    0, ServerConstants::PUBLIC_DIR.size()) == ServerConstants::PUBLIC_DIR)
-				req.path = req.path.substr(ServerConstants::PUBLIC_DIR.size());
+			// Run the middleware chain around route dispatch
+			res = pipeline ? pipeline(req, match) : dispatch(req, match);
+			req.body_stream = nullptr;
 
-			// Dispatch to registered dynamic route, or fallback to file system
-			if (routes.contains(req.path))
-			{
-				res = routes.at(req.path)(req);
-			}
-			else
-			{
-				res = handle_static_file(req.path);
-			}
+			// Whatever a streaming handler left unread must not be parsed as the next request
+			if (stream_body && !body->discard(ServerConstants::MAX_DRAIN_BYTES))
+				req.keep_alive = false;
 		}
 
-		// 5. Response Finalization
-		res.keep_alive = req.keep_alive;
-		if (res.status_code >= 400)
-			res.keep_alive = false; // Force close on server errors
-
-		std::string raw_response = res.to_string();
-		const char *data_ptr = raw_response.data();
-		size_t total_to_send = raw_response.length();
-		size_t total_sent = 0;
-
-		// Robust send loop: Ensures the entire payload is transmitted even if the OS buffers fill up
-		while (total_sent < total_to_send)
+		// 5. A deferred answer is sent later; the connection waits on the event loop, not on this thread
+		if (res.defer && !error_occurred)
 		{
-			long sent = send(client_socket, data_ptr + total_sent, total_to_send - total_sent, 0);
-			if (sent <= 0)
-				break;
-			total_sent += sent;
+			park(client_socket, std::move(connection_buffer), req, std::move(res));
+			return;
 		}
 
-		log_request(req, res);
+		// A WebSocket handshake or an event stream ends HTTP on this connection; the event loop serves it from here on
+		if (((res.websocket && res.status_code == 101) || res.event_stream) && !error_occurred &&
+		    req.method_id != HttpMethod::HEAD)
+		{
+			hand_off(client_socket, std::move(connection_buffer), req, std::move(res));
+			return;
+		}
 
+		// 6. Response Finalization
 		// Terminate Keep-Alive loop if requested by client or forced by an error
-		if (!res.keep_alive)
+		if (!send_response(client_socket, req, res))
 		{
 			break;
 		}
@@ -289,6 +416,161 @@ void HttpServer::handle_client( int client_socket ) const
 	close(client_socket);
 }
 
+bool HttpServer::send_response( int client_socket, const RequestInfo &req, Response &res ) const
+{
+	res.keep_alive = req.keep_alive;
+	if (res.status_code >= 400)
+		res.keep_alive = false; // Force close on server errors
+
+	// Send the head (and a buffered body) in one go
+	bool head_sent = send_all(client_socket, res.to_string());
+	if (!head_sent)
+		res.keep_alive = false;
+
+	// A streaming body follows as chunks while the handler's producer runs; HEAD gets no body
+	if (res.stream && head_sent && req.method_id != HttpMethod::HEAD)
+	{
+		ResponseWriter writer(client_socket);
+		try
+		{
+			res.stream(writer);
+			writer.finish();
+		}
+		catch (const std::exception &e)
+		{
+			// The status line is already out; closing without the final chunk tells the client it is truncated
+			std::cerr << "[ERROR] Streaming response aborted: " << e.what() << std::endl;
+			res.keep_alive = false;
+		}
+		if (writer.failed())
+			res.keep_alive = false;
+	}
+
+	log_request(req, res);
+	return res.keep_alive;
+}
+
+void HttpServer::park( int client_socket, std::string buffer, const RequestInfo &req, Response res )
+{
+	auto defer = std::move(res.defer);
+	res.defer = nullptr;
+	auto deadline = Reactor::Clock::now() + res.defer_timeout;
+
+	// Only what send_response() needs travels with the connection
+	RequestInfo parked;
+	parked.method = req.method;
+	parked.method_id = req.method_id;
+	parked.path = req.path;
+	parked.keep_alive = req.keep_alive;
+
+	std::shared_ptr<PendingResponse> pending(
+		new PendingResponse(this, client_socket, std::move(buffer), std::move(parked), std::move(res)));
+
+	// Posted before the handler sees it, so a completion always finds the connection registered
+	reactor.post([this, pending, deadline]
+	{
+		if (pending->finished())
+			return; // Answered before it was even parked; the completion takes it from here
+
+		// Only a hang-up is of interest; bytes of a next request stay in the kernel until resumed
+		reactor.watch(pending->socket, EPOLLRDHUP, [this, pending]( uint32_t )
+		{
+			reactor.unwatch(pending->socket);
+			if (pending->done.exchange(true))
+				return;
+			reactor.cancel_timer(pending->timer);
+			close(pending->socket);
+		});
+		pending->timer = reactor.add_timer(deadline, [pending]
+		{
+			pending->complete(std::move(pending->fallback));
+		});
+	});
+
+	defer(pending);
+}
+
+void HttpServer::hand_off( int client_socket, std::string buffer, const RequestInfo &req, Response res )
+{
+	// Serialized before the callbacks are taken out, so an event stream's head announces its chunked body
+	bool sent = send_all(client_socket, res.to_string());
+	auto on_websocket = std::move(res.websocket);
+	auto on_event_stream = std::move(res.event_stream);
+	log_request(req, res);
+	if (!sent)
+	{
+		close(client_socket);
+		return;
+	}
+
+	// The connection object owns the descriptor from now on and closes it when the connection ends
+	if (on_websocket)
+	{
+		auto socket = std::make_shared<WebSocket>(reactor, client_socket, std::move(buffer), WebSocket::Options{});
+		reactor.post([socket, on_open = std::move(on_websocket)]
+		{
+			socket->start(on_open);
+		});
+	}
+	else
+	{
+		auto stream = std::make_shared<EventStream>(reactor, client_socket, EventStream::Options{});
+		reactor.post([stream, on_open = std::move(on_event_stream)]
+		{
+			stream->start(on_open);
+		});
+	}
+}
+
+bool PendingResponse::complete( Response res )
+{
+	if (done.exchange(true))
+		return false;
+
+	res.defer = nullptr;
+	res.stream = nullptr;
+	answer = std::move(res);
+
+	// Detach from the event loop, then let a worker send the answer
+	server->reactor.post([pending = shared_from_this()]
+	{
+		HttpServer *owner = pending->server;
+		owner->reactor.unwatch(pending->socket);
+		owner->reactor.cancel_timer(pending->timer);
+		owner->enqueue({pending->socket, pending});
+	});
+	return true;
+}
+
+RouteMatch HttpServer::resolve( RequestInfo &req ) const
+{
+	// Fixed route table first (one hash), then the dynamic router (one tree walk)
+	RouteMatch match = static_routes ? static_routes(req.method_id, req.path) : RouteMatch{};
+	if (!match.path_found())
+		match = router.match(req.method_id, req);
+	return match;
+}
+
+Response HttpServer::dispatch( RequestInfo &req, const RouteMatch &match ) const
+{
+	// A matched handler, else 405 for a known path, else the file system
+	if (match.has_handler())
+		return match.invoke(req);
+
+	if (match.method_not_allowed())
+	{
+		Response res;
+		res.status_code = 405;
+		res.status_text = "Method Not Allowed";
+		res.content_type = "text/plain";
+		res.headers["Allow"] = Router::format_allow(match.allowed_methods);
+		res.body = "Method not allowed.";
+		return res;
+	}
+
+	return handle_static_file(req.path);
+}
+
 Response HttpServer::handle_static_file( const std::string &requested_path )
 {
 	Response res;
@@ -346,8 +628,9 @@ void HttpServer::stop()
 		server_fd = -1;
 	}
 
-	// 2. Wake up all dormant threads
+	// 2. Wake up all dormant threads and stop watching parked connections
 	cv.notify_all();
+	reactor.stop();
 
 	// 3. Join threads to prevent orphaned processes
 	for (std::thread &worker: thread_pool)
@@ -362,7 +645,7 @@ void HttpServer::stop()
 	std::lock_guard <std::mutex> lock(queue_mutex);
 	while (!task_queue.empty())
 	{
-		close(task_queue.front());
+		close(task_queue.front().socket);
 		task_queue.pop();
 	}
 
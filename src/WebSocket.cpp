@@ -0,0 +1,494 @@
+#include "../include/WebSocket.hpp"
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+    constexpr std::string_view HANDSHAKE_GUID = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+    constexpr size_t READ_SIZE = 16384;
+    constexpr uint32_t READ_EVENTS = EPOLLIN | EPOLLRDHUP;
+
+    // Close status codes (RFC 6455, section 7.4.1)
+    constexpr uint16_t CLOSE_PROTOCOL_ERROR = 1002;
+    constexpr uint16_t CLOSE_INVALID_DATA = 1007;
+    constexpr uint16_t CLOSE_POLICY_VIOLATION = 1008;
+    constexpr uint16_t CLOSE_TOO_BIG = 1009;
+
+    bool contains_token(std::string_view header, std::string_view token) {
+        // Header values such as "keep-alive, Upgrade" are comma-separated and case-insensitive
+        while (!header.empty()) {
+            size_t comma = header.find(',');
+            std::string_view item = header.substr(0, comma);
+            while (!item.empty() && item.front() == ' ') item.remove_prefix(1);
+            while (!item.empty() && item.back() == ' ') item.remove_suffix(1);
+            if (item.size() == token.size() &&
+                std::equal(item.begin(), item.end(), token.begin(), [](char a, char b) {
+                    return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b));
+                })) {
+                return true;
+            }
+            if (comma == std::string_view::npos) break;
+            header.remove_prefix(comma + 1);
+        }
+        return false;
+    }
+
+    uint32_t rotl(uint32_t value, int bits) {
+        return (value << bits) | (value >> (32 - bits));
+    }
+
+    // SHA-1 is only used for the handshake, where the protocol mandates it; it is not a security boundary
+    std::array<uint8_t, 20> sha1(std::string_view data) {
+        uint32_t h[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+
+        std::string padded(data);
+        uint64_t bit_length = static_cast<uint64_t>(data.size()) * 8;
+        padded += static_cast<char>(0x80);
+        while (padded.size() % 64 != 56) padded += '\0';
+        for (int shift = 56; shift >= 0; shift -= 8) padded += static_cast<char>(bit_length >> shift);
+
+        for (size_t chunk = 0; chunk < padded.size(); chunk += 64) {
+            uint32_t w[80];
+            for (int i = 0; i < 16; ++i) {
+                const auto* p = reinterpret_cast<const uint8_t*>(padded.data() + chunk + i * 4);
+                w[i] = (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3];
+            }
+            for (int i = 16; i < 80; ++i) w[i] = rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+
+            uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+            for (int i = 0; i < 80; ++i) {
+                uint32_t f, k;
+                if (i < 20) {
+                    f = (b & c) | (~b & d);
+                    k = 0x5A827999;
+                } else if (i < 40) {
+                    f = b ^ c ^ d;
+                    k = 0x6ED9EBA1;
+                } else if (i < 60) {
+                    f = (b & c) | (b & d) | (c & d);
+                    k = 0x8F1BBCDC;
+                } else {
+                    f = b ^ c ^ d;
+                    k = 0xCA62C1D6;
+                }
+                uint32_t next = rotl(a, 5) + f + e + k + w[i];
+                e = d;
+                d = c;
+                c = rotl(b, 30);
+                b = a;
+                a = next;
+            }
+            h[0] += a;
+            h[1] += b;
+            h[2] += c;
+            h[3] += d;
+            h[4] += e;
+        }
+
+        std::array<uint8_t, 20> digest{};
+        for (int i = 0; i < 20; ++i) digest[i] = static_cast<uint8_t>(h[i / 4] >> (24 - (i % 4) * 8));
+        return digest;
+    }
+
+    std::string base64(const uint8_t* data, size_t size) {
+        static constexpr char ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        std::string out;
+        out.reserve((size + 2) / 3 * 4);
+        for (size_t i = 0; i < size; i += 3) {
+            uint32_t group = uint32_t(data[i]) << 16;
+            if (i + 1 < size) group |= uint32_t(data[i + 1]) << 8;
+            if (i + 2 < size) group |= data[i + 2];
+            out += ALPHABET[(group >> 18) & 63];
+            out += ALPHABET[(group >> 12) & 63];
+            out += i + 1 < size ? ALPHABET[(group >> 6) & 63] : '=';
+            out += i + 2 < size ? ALPHABET[group & 63] : '=';
+        }
+        return out;
+    }
+
+    // Text messages must be valid UTF-8 (RFC 6455, section 8.1): no overlongs, surrogates or code points past U+10FFFF
+    bool valid_utf8(std::string_view text) {
+        const auto* p = reinterpret_cast<const uint8_t*>(text.data());
+        const auto* end = p + text.size();
+        while (p < end) {
+            uint8_t lead = *p++;
+            if (lead < 0x80) continue;
+
+            int extra;
+            uint32_t cp;
+            if ((lead & 0xE0) == 0xC0) {
+                extra = 1;
+                cp = lead & 0x1F;
+            } else if ((lead & 0xF0) == 0xE0) {
+                extra = 2;
+                cp = lead & 0x0F;
+            } else if ((lead & 0xF8) == 0xF0) {
+                extra = 3;
+                cp = lead & 0x07;
+            } else {
+                return false;
+            }
+            if (end - p < extra) return false;
+            for (int i = 0; i < extra; ++i) {
+                if ((p[i] & 0xC0) != 0x80) return false;
+                cp = (cp << 6) | (p[i] & 0x3F);
+            }
+            p += extra;
+
+            static constexpr uint32_t MIN_FOR_LENGTH[] = {0, 0x80, 0x800, 0x10000};
+            if (cp < MIN_FOR_LENGTH[extra] || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) return false;
+        }
+        return true;
+    }
+}
+
+WsFrameParser::Status WsFrameParser::next(std::string& buffer, WsFrame& frame) const {
+    if (buffer.size() < 2) return Status::NEED_MORE;
+    const auto* bytes = reinterpret_cast<const uint8_t*>(buffer.data());
+
+    bool fin = bytes[0] & 0x80;
+    uint8_t opcode = bytes[0] & 0x0F;
+    bool masked = bytes[1] & 0x80;
+    uint64_t length = bytes[1] & 0x7F;
+
+    // No extensions are negotiated, so the reserved bits must be clear; clients must mask
+    if ((bytes[0] & 0x70) || !masked) return Status::ERROR;
+    bool control = opcode & 0x08;
+    if (opcode > 0xA || (opcode > 0x2 && opcode < 0x8)) return Status::ERROR;
+    if (control && (!fin || length > 125)) return Status::ERROR;
+
+    size_t header = 2;
+    if (length == 126) {
+        if (buffer.size() < 4) return Status::NEED_MORE;
+        length = (uint64_t(bytes[2]) << 8) | bytes[3];
+        header = 4;
+    } else if (length == 127) {
+        if (buffer.size() < 10) return Status::NEED_MORE;
+        length = 0;
+        for (int i = 2; i < 10; ++i) length = (length << 8) | bytes[i];
+        header = 10;
+    }
+    if (length > max_payload) return Status::ERROR;
+
+    size_t total = header + 4 + length;
+    if (buffer.size() < total) return Status::NEED_MORE;
+
+    const uint8_t* mask = bytes + header;
+    frame.fin = fin;
+    frame.opcode = static_cast<WsOpcode>(opcode);
+    frame.payload.assign(buffer, header + 4, length);
+    for (size_t i = 0; i < length; ++i) frame.payload[i] = static_cast<char>(frame.payload[i] ^ mask[i & 3]);
+
+    buffer.erase(0, total);
+    return Status::FRAME;
+}
+
+std::string ws_encode_frame(WsOpcode opcode, std::string_view payload) {
+    std::string frame;
+    frame.reserve(payload.size() + 10);
+    frame += static_cast<char>(0x80 | static_cast<uint8_t>(opcode));
+
+    uint64_t length = payload.size();
+    if (length < 126) {
+        frame += static_cast<char>(length);
+    } else if (length <= 0xFFFF) {
+        frame += static_cast<char>(126);
+        frame += static_cast<char>(length >> 8);
+        frame += static_cast<char>(length);
+    } else {
+        frame += static_cast<char>(127);
+        for (int shift = 56; shift >= 0; shift -= 8) frame += static_cast<char>(length >> shift);
+    }
+    frame += payload;
+    return frame;
+}
+
+std::string ws_accept_key(std::string_view client_key) {
+    std::string input(client_key);
+    input += HANDSHAKE_GUID;
+    std::array<uint8_t, 20> digest = sha1(input);
+    return base64(digest.data(), digest.size());
+}
+
+Response websocket_upgrade(const RequestInfo& req, WebSocketOpen on_open) {
+    Response res;
+    res.content_type = "text/plain";
+
+    std::string_view key = req.header("Sec-WebSocket-Key");
+    if (req.method_id != HttpMethod::GET || !contains_token(req.header("Upgrade"), "websocket") ||
+        !contains_token(req.header("Connection"), "upgrade") || key.empty()) {
+        res.status_code = 400;
+        res.status_text = "Bad Request";
+        res.body = "Expected a WebSocket handshake.";
+        return res;
+    }
+    if (req.header("Sec-WebSocket-Version") != "13") {
+        res.status_code = 426;
+        res.status_text = "Upgrade Required";
+        res.headers["Sec-WebSocket-Version"] = "13";
+        return res;
+    }
+
+    res.status_code = 101;
+    res.status_text = "Switching Protocols";
+    res.headers["Upgrade"] = "websocket";
+    res.headers["Connection"] = "Upgrade";
+    res.headers["Sec-WebSocket-Accept"] = ws_accept_key(key);
+    res.websocket = std::move(on_open);
+    return res;
+}
+
+WebSocket::WebSocket(Reactor& reactor, int socket, std::string received, Options options)
+    : reactor(reactor), socket(socket), options(options), parser(options.max_message), input(std::move(received)) {}
+
+WebSocket::~WebSocket() {
+    if (!closed) ::close(socket);
+}
+
+void WebSocket::start(const WebSocketOpen& on_open) {
+    fcntl(socket, F_SETFL, fcntl(socket, F_GETFL, 0) | O_NONBLOCK);
+
+    std::shared_ptr<WebSocket> self = shared_from_this();
+    reactor.watch(socket, READ_EVENTS, [self](uint32_t events) { self->handle_events(events); });
+    schedule_ping();
+    if (on_open) on_open(self);
+
+    // Frames the client sent right behind its handshake are already in the buffer
+    if (!input.empty() && !read_input()) shutdown();
+}
+
+void WebSocket::handle_events(uint32_t events) {
+    if (closed) return;
+    if (events & (EPOLLERR | EPOLLHUP)) {
+        shutdown();
+        return;
+    }
+    if ((events & EPOLLOUT) && !flush()) {
+        shutdown();
+        return;
+    }
+    if ((events & (EPOLLIN | EPOLLRDHUP)) && !read_input()) shutdown();
+}
+
+bool WebSocket::read_input() {
+    char chunk[READ_SIZE];
+    while (true) {
+        ssize_t received = recv(socket, chunk, sizeof(chunk), 0);
+        if (received > 0) {
+            input.append(chunk, static_cast<size_t>(received));
+            heard_from_peer = true;
+            continue;
+        }
+        if (received == 0) return false; // Peer closed the TCP connection
+        if (errno == EINTR) continue;
+        if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+        return false;
+    }
+
+    WsFrame frame;
+    while (!closed) {
+        WsFrameParser::Status status = parser.next(input, frame);
+        if (status == WsFrameParser::Status::NEED_MORE) break;
+        if (status == WsFrameParser::Status::ERROR) {
+            send_close(CLOSE_PROTOCOL_ERROR);
+            return true; // The close frame is flushed, then the socket released
+        }
+        if (!handle_frame(frame)) return true;
+    }
+    return true;
+}
+
+bool WebSocket::handle_frame(WsFrame& frame) {
+    switch (frame.opcode) {
+        case WsOpcode::PING:
+            queue(std::make_shared<const std::string>(ws_encode_frame(WsOpcode::PONG, frame.payload)));
+            return true;
+        case WsOpcode::PONG:
+            return true;
+        case WsOpcode::CLOSE: {
+            // Echo the peer's status code to complete the closing handshake
+            uint16_t code = 1000;
+            if (frame.payload.size() >= 2) {
+                code = static_cast<uint16_t>((uint8_t(frame.payload[0]) << 8) | uint8_t(frame.payload[1]));
+            }
+            send_close(code);
+            return false;
+        }
+        case WsOpcode::TEXT:
+        case WsOpcode::BINARY:
+            // A new message may not start in the middle of a fragmented one
+            if (fragmented) {
+                send_close(CLOSE_PROTOCOL_ERROR);
+                return false;
+            }
+            message_opcode = frame.opcode;
+            message = std::move(frame.payload);
+            break;
+        case WsOpcode::CONTINUATION:
+            if (!fragmented) {
+                send_close(CLOSE_PROTOCOL_ERROR);
+                return false;
+            }
+            if (message.size() + frame.payload.size() > options.max_message) {
+                send_close(CLOSE_TOO_BIG);
+                return false;
+            }
+            message += frame.payload;
+            break;
+    }
+
+    fragmented = !frame.fin;
+    if (fragmented) return true;
+
+    if (message_opcode == WsOpcode::TEXT && !valid_utf8(message)) {
+        send_close(CLOSE_INVALID_DATA);
+        return false;
+    }
+    if (message_handler) message_handler(*this, message);
+    message.clear();
+    return !closed && !close_sent;
+}
+
+void WebSocket::send_text(std::string_view text) {
+    if (!is_open()) return;
+    send(std::make_shared<const std::string>(ws_encode_frame(WsOpcode::TEXT, text)));
+}
+
+void WebSocket::send(std::shared_ptr<const std::string> frame) {
+    if (!is_open()) return;
+    reactor.post([self = shared_from_this(), frame = std::move(frame)]() mutable { self->queue(std::move(frame)); });
+}
+
+void WebSocket::close(uint16_t code) {
+    if (!open.exchange(false)) return;
+    reactor.post([self = shared_from_this(), code] { self->send_close(code); });
+}
+
+void WebSocket::queue(std::shared_ptr<const std::string> frame) {
+    if (closed || close_sent) return;
+    buffered += frame->size();
+    outbox.push_back(std::move(frame));
+
+    // A peer this far behind is not reading; holding more for it only wastes memory
+    if (buffered > options.max_buffered) {
+        shutdown();
+        return;
+    }
+    if (!writing && !flush()) shutdown();
+}
+
+void WebSocket::follow(FanOut& source) {
+    if (closed || feed) return;
+    std::weak_ptr<WebSocket> weak = weak_from_this();
+    feed_source = &source;
+    feed = source.subscribe(
+        [weak] {
+            if (std::shared_ptr<WebSocket> self = weak.lock()) self->pump();
+        },
+        [weak] {
+            // Too far behind under the DISCONNECT policy; the client reconnects and catches up
+            if (std::shared_ptr<WebSocket> self = weak.lock()) self->send_close(CLOSE_POLICY_VIOLATION);
+        });
+}
+
+void WebSocket::pump() {
+    // While EPOLLOUT is watched, the next writable event pulls the new frames
+    if (!closed && !writing && !flush()) shutdown();
+}
+
+bool WebSocket::refill() {
+    if (!feed || close_sent) return false;
+    SharedFrame frame = feed->pop();
+    if (!frame) return false;
+    buffered += frame->bytes.size();
+    // Shares the frame's ownership; the bytes are not copied
+    outbox.emplace_back(frame, &frame->bytes);
+    return true;
+}
+
+bool WebSocket::flush() {
+    while (!outbox.empty() || refill()) {
+        const std::string& frame = *outbox.front();
+        ssize_t sent = ::send(socket, frame.data() + outbox_offset, frame.size() - outbox_offset, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) return false;
+
+            // The kernel buffer is full; resume when the socket becomes writable
+            if (!writing) {
+                writing = true;
+                reactor.modify(socket, READ_EVENTS | EPOLLOUT);
+            }
+            return true;
+        }
+
+        outbox_offset += static_cast<size_t>(sent);
+        buffered -= static_cast<size_t>(sent);
+        if (outbox_offset == frame.size()) {
+            outbox.pop_front();
+            outbox_offset = 0;
+        }
+    }
+
+    if (writing) {
+        writing = false;
+        reactor.modify(socket, READ_EVENTS);
+    }
+    // Once our close frame is out there is nothing left to say; release the socket
+    if (close_sent) shutdown();
+    return true;
+}
+
+void WebSocket::send_close(uint16_t code) {
+    if (closed || close_sent) return;
+    open.store(false, std::memory_order_release);
+
+    char payload[2] = {static_cast<char>(code >> 8), static_cast<char>(code & 0xFF)};
+    buffered += 4;
+    outbox.push_back(std::make_shared<const std::string>(ws_encode_frame(WsOpcode::CLOSE, {payload, 2})));
+    close_sent = true;
+    if (!writing && !flush()) shutdown();
+}
+
+void WebSocket::schedule_ping() {
+    std::weak_ptr<WebSocket> weak = weak_from_this();
+    ping_timer = reactor.add_timer(Reactor::Clock::now() + options.ping_interval, [weak] {
+        std::shared_ptr<WebSocket> self = weak.lock();
+        if (!self || self->closed) return;
+        self->ping_timer = 0;
+
+        // Silent for a whole interval after a ping: the peer (or a middlebox) is gone
+        if (!self->heard_from_peer) {
+            self->shutdown();
+            return;
+        }
+        self->heard_from_peer = false;
+        self->queue(std::make_shared<const std::string>(ws_encode_frame(WsOpcode::PING, {})));
+        if (!self->closed) self->schedule_ping();
+    });
+}
+
+void WebSocket::shutdown() {
+    if (closed) return;
+    closed = true;
+    open.store(false, std::memory_order_release);
+
+    reactor.unwatch(socket);
+    if (ping_timer) reactor.cancel_timer(ping_timer);
+    ::close(socket);
+    outbox.clear();
+    if (feed) {
+        feed_source->unsubscribe(*feed);
+        feed.reset();
+    }
+
+    // Dropped before the call so subscribers holding this connection can let go of it
+    CloseHandler handler = std::move(close_handler);
+    message_handler = nullptr;
+    if (handler) handler(*this);
+}
@@ -0,0 +1,185 @@
+#include "../include/WriteQueue.hpp"
+#include "../include/Pipeline.hpp"
+#include <algorithm>
+#include <iostream>
+#include <span>
+#include <sstream>
+
+namespace {
+    // Appends one element to a Postgres text[] literal: quoted, with '"' and '\' escaped
+    void append_array_element(std::string& array, const std::string& value) {
+        array += array.size() > 1 ? ",\"" : "\"";
+        for (char c : value) {
+            // libpq sends parameters as C strings; an embedded NUL would cut the whole array short
+            if (c == '\0') continue;
+            if (c == '"' || c == '\\') array += '\\';
+            array += c;
+        }
+        array += '"';
+    }
+
+    // The two columns of INSERT_BATCH's parameters, as Postgres text[] literals
+    std::pair<std::string, std::string> to_arrays(std::span<const Message> messages) {
+        std::string users = "{";
+        std::string texts = "{";
+        for (const Message& message : messages) {
+            append_array_element(users, message.user);
+            append_array_element(texts, message.text);
+        }
+        users += '}';
+        texts += '}';
+        return {std::move(users), std::move(texts)};
+    }
+}
+
+WriteBehindQueue::WriteBehindQueue(PipelinePool& pool, Options options)
+    : pool(pool), options(options), open(std::make_shared<Batch>()) {
+    // Two array parameters instead of one pair per row, so a single prepared statement fits any batch size
+    pool.statements().add(INSERT_BATCH, R"(
+        INSERT INTO messages (username, content)
+        SELECT * FROM unnest($1::text[], $2::text[])
+        RETURNING id, username, content, to_char(created_at, 'DD-MM-YYYY HH24:MI')
+    )");
+    writer = std::thread(&WriteBehindQueue::run, this);
+}
+
+WriteBehindQueue::~WriteBehindQueue() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    has_work.notify_one();
+    writer.join();
+}
+
+bool WriteBehindQueue::submit(Message message) {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (stopping || open->messages.size() >= options.max_pending) {
+        rejected.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    if (open->messages.empty()) open_since = std::chrono::steady_clock::now();
+    open->messages.push_back(std::move(message));
+    submitted.fetch_add(1, std::memory_order_relaxed);
+
+    // The writer only needs waking for the first message of a batch and once the batch is full
+    size_t pending = open->messages.size();
+    if (pending == 1 || pending == options.max_batch) has_work.notify_one();
+
+    if (options.durability == Durability::ENQUEUE) return true;
+
+    std::shared_ptr<Batch> batch = open;
+    batch_done.wait(lock, [&batch] { return batch->done; });
+    return batch->ok;
+}
+
+void WriteBehindQueue::flush() {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (open->messages.empty()) {
+        batch_done.wait(lock, [this] { return !writing; });
+        return;
+    }
+    // Batches are written in order, so once the open one is done so is everything before it
+    std::shared_ptr<Batch> batch = open;
+    batch_done.wait(lock, [&batch] { return batch->done; });
+}
+
+void WriteBehindQueue::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        has_work.wait(lock, [this] { return stopping || !open->messages.empty(); });
+        if (open->messages.empty()) break;
+
+        // Let the batch collect company for up to flush_interval, unless it is full or we are shutting down
+        has_work.wait_until(lock, open_since + options.flush_interval, [this] {
+            return stopping || open->messages.size() >= options.max_batch;
+        });
+
+        std::shared_ptr<Batch> batch = std::move(open);
+        open = std::make_shared<Batch>();
+        writing = true;
+        lock.unlock();
+
+        bool ok = true;
+        const std::vector<Message>& messages = batch->messages;
+        for (size_t first = 0; first < messages.size(); first += options.max_batch) {
+            size_t count = std::min(options.max_batch, messages.size() - first);
+            if (!write({messages.begin() + static_cast<std::ptrdiff_t>(first),
+                        messages.begin() + static_cast<std::ptrdiff_t>(first + count)})) {
+                ok = false;
+            }
+        }
+
+        lock.lock();
+        batch->done = true;
+        batch->ok = ok;
+        writing = false;
+        batch_done.notify_all();
+    }
+}
+
+bool WriteBehindQueue::write(const std::vector<Message>& messages) {
+    std::vector<PipelineResult> results;
+    try {
+        PipelinePool::Lease conn = pool.acquire();
+        QueryPipeline pipeline(*conn);
+
+        // A lone statement commits by itself at the sync point: one round trip, not BEGIN, INSERT, COMMIT
+        auto [users, texts] = to_arrays(messages);
+        pipeline.exec_prepared(INSERT_BATCH, users, texts);
+        results = pipeline.run();
+
+        if (!results.front().ok() && messages.size() > 1) {
+            // The server rejected the data (e.g., invalid UTF-8); retry row by row so only the culprit
+            // is lost. Each row gets its own transaction, but all of them share one round trip.
+            for (const Message& message : messages) {
+                auto [user, text] = to_arrays({&message, 1});
+                pipeline.exec_prepared(INSERT_BATCH, user, text);
+                pipeline.sync();
+            }
+            results = pipeline.run();
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "[DB ERROR] Could not save " << messages.size() << " message(s): " << e.what() << std::endl;
+        failed.fetch_add(messages.size(), std::memory_order_relaxed);
+        return false;
+    }
+
+    std::vector<Message> stored;
+    size_t lost = 0;
+    for (const PipelineResult& result : results) {
+        if (!result.ok()) {
+            std::cerr << "[DB ERROR] Could not save message: " << result.error() << std::endl;
+            ++lost;
+            continue;
+        }
+        for (size_t row = 0; row < result.size(); ++row) {
+            stored.push_back({result.as_string(row, 1), result.as_string(row, 2),
+                              result.as_string(row, 3), result.as_int(row, 0)});
+        }
+    }
+
+    failed.fetch_add(lost, std::memory_order_relaxed);
+    written.fetch_add(stored.size(), std::memory_order_relaxed);
+    batches.fetch_add(1, std::memory_order_relaxed);
+    if (options.on_commit && !stored.empty()) options.on_commit(std::move(stored));
+    return lost == 0;
+}
+
+std::string WriteBehindQueue::to_prometheus() const {
+    size_t pending;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending = open->messages.size();
+    }
+
+    std::ostringstream out;
+    out << "chat_write_queue_pending " << pending << "\n";
+    out << "chat_write_queue_submitted_total " << submitted.load(std::memory_order_relaxed) << "\n";
+    out << "chat_write_queue_rejected_total " << rejected.load(std::memory_order_relaxed) << "\n";
+    out << "chat_write_queue_written_total " << written.load(std::memory_order_relaxed) << "\n";
+    out << "chat_write_queue_failed_total " << failed.load(std::memory_order_relaxed) << "\n";
+    out << "chat_write_queue_batches_total " << batches.load(std::memory_order_relaxed) << "\n";
+    return out.str();
+}